@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#include "audio.h"
+#include "ring.h"
+#include "config.h"
+
+#define AUDIO_RING_SIZE 16
+#define AUDIO_SAMPLES 512
+
+typedef struct AudioFrame {
+    float freq, amp;
+} AudioFrame;
+
+static Ring frames;
+static SDL_AudioDeviceID device;
+static bool enabled = false;
+static bool own_driver = false;
+static const char *driver_name = NULL;
+
+// sim side, the tone of the tick in progress
+static AudioFrame pending;
+
+// callback side
+static AudioFrame from, to;
+static int frame_pos, frame_len;
+static double phase; // in cycles
+static double rate;
+static bool started = false;
+
+static atomic_ullong callbacks, underruns, overruns;
+
+static void next_frame(void)
+{
+    AudioFrame f;
+
+    from = to;
+    if (ring_pop(&frames, &f)) {
+        to = f;
+        started = true;
+    } else if (started) {
+        atomic_fetch_add_explicit(&underruns, 1, memory_order_relaxed);
+    }
+
+    // a tone that starts from silence starts at its own pitch
+    if (from.amp == 0)
+        from.freq = to.freq;
+
+    frame_pos = 0;
+}
+
+static void audio_callback(void *userdata, Uint8 *stream, int len)
+{
+    float *out = (float *)stream;
+    int n = len / (int)sizeof(float);
+
+    atomic_fetch_add_explicit(&callbacks, 1, memory_order_relaxed);
+
+    // the sim runs on its own clock, don't let the latency build up
+    AudioFrame skipped;
+    while (ring_count(&frames) > AUDIO_MAX_BACKLOG && ring_pop(&frames, &skipped))
+        atomic_fetch_add_explicit(&overruns, 1, memory_order_relaxed);
+
+    for (int i = 0; i < n; i++) {
+        if (frame_pos == frame_len)
+            next_frame();
+
+        float k = (float)frame_pos++ / frame_len;
+        float freq = from.freq + (to.freq - from.freq) * k;
+        float amp = from.amp + (to.amp - from.amp) * k;
+
+        phase += freq / rate;
+        phase -= floor(phase);
+        out[i] = amp * sinf(2 * (float)M_PI * (float)phase);
+    }
+}
+
+bool audio_init(const char *driver)
+{
+    own_driver = driver != NULL;
+    if (own_driver ? SDL_AudioInit(driver) : SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        fprintf(stderr, "audio: disabled: %s\n", SDL_GetError());
+        return false;
+    }
+
+    ring_init(&frames, sizeof(AudioFrame), AUDIO_RING_SIZE);
+
+    SDL_AudioSpec want = {
+        .freq = AUDIO_RATE,
+        .format = AUDIO_F32SYS,
+        .channels = 1,
+        .samples = AUDIO_SAMPLES,
+        .callback = audio_callback,
+    };
+    SDL_AudioSpec have;
+
+    device = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    if (!device) {
+        fprintf(stderr, "audio: disabled: OpenAudioDevice: %s\n", SDL_GetError());
+        if (own_driver)
+            SDL_AudioQuit();
+        else
+            SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    rate = have.freq;
+    frame_len = have.freq / CONFIG_SIM_HZ;
+    frame_pos = frame_len;
+    driver_name = SDL_GetCurrentAudioDriver();
+    enabled = true;
+
+    SDL_PauseAudioDevice(device, 0);
+    return true;
+}
+
+void audio_shutdown(void)
+{
+    if (!enabled)
+        return;
+
+    SDL_CloseAudioDevice(device);
+    if (own_driver)
+        SDL_AudioQuit();
+    else
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    enabled = false;
+}
+
+void audio_tone(float freq, float amp)
+{
+    pending = (AudioFrame) { freq, amp };
+}
+
+void audio_tick(void)
+{
+    if (enabled && !ring_push(&frames, &pending))
+        atomic_fetch_add_explicit(&overruns, 1, memory_order_relaxed);
+
+    // scenes that don't call audio_tone() are silent
+    pending = (AudioFrame) {0};
+}
+
+void audio_stats(AudioStats *stats)
+{
+    stats->enabled = enabled;
+    stats->driver = driver_name;
+    stats->callbacks = atomic_load_explicit(&callbacks, memory_order_relaxed);
+    stats->underruns = atomic_load_explicit(&underruns, memory_order_relaxed);
+    stats->overruns = atomic_load_explicit(&overruns, memory_order_relaxed);
+}
@@ -0,0 +1,39 @@
+#ifndef _AUDIO_H
+#define _AUDIO_H
+
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+/*
+ * Audible output of the selected scene. Every sim tick the scene may set the
+ * tone a listener would hear with audio_tone(), sim_tick() then pushes it as
+ * one control frame into a lock-free single-producer ring. The SDL audio
+ * callback consumes one frame per AUDIO_RATE / CONFIG_SIM_HZ samples and
+ * synthesizes a sine, ramping frequency and amplitude linearly across the
+ * frame; it never locks or allocates. An empty ring when the next frame is
+ * due holds the last tone and counts as an underrun, a backlog past
+ * AUDIO_MAX_BACKLOG frames (the sim and audio clocks drift) is skipped.
+ */
+
+#define AUDIO_RATE 48000
+#define AUDIO_MAX_BACKLOG 4
+
+typedef struct AudioStats {
+    bool enabled;
+    const char *driver;
+    Uint64 callbacks;
+    Uint64 underruns; // frame due but none queued
+    Uint64 overruns;  // frames the sim could not queue or the callback skipped
+} AudioStats;
+
+// NULL picks SDL's default driver, failing to open a device leaves audio off
+bool audio_init(const char *driver);
+void audio_shutdown(void);
+
+void audio_tone(float freq, float amp);
+void audio_tick(void);
+
+void audio_stats(AudioStats *stats);
+
+#endif /* _AUDIO_H */
@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#include "bench.h"
+#include "simstate.h"
+#include "draw.h"
+#include "drawlist.h"
+#include "text.h"
+#include "wave.h"
+#include "fdm.h"
+#include "fourier.h"
+#include "pool.h"
+#include "sim.h"
+#include "prof.h"
+#include "comp.h"
+#include "framecache.h"
+
+extern SDL_Renderer *renderer;
+
+/*
+ * Headless benchmark: every scene is run for a fixed number of frames with
+ * its default parameters and without a frame cap, timing each stage of the
+ * frame separately.
+ */
+
+#define BENCH_WARMUP_FRAMES 20
+
+typedef enum BenchStage {
+    STAGE_SIM,
+    STAGE_SCENE,
+    STAGE_WIDGETS,
+    STAGE_DRAW,
+    STAGE_TEXT,
+    STAGE_FRAME,
+    STAGE_END,
+} BenchStage;
+
+static const char *stage_names[STAGE_END] = {
+    [STAGE_SIM] = "sim",
+    [STAGE_SCENE] = "scene",
+    [STAGE_WIDGETS] = "widgets",
+    [STAGE_DRAW] = "draw",
+    [STAGE_TEXT] = "text",
+    [STAGE_FRAME] = "frame",
+};
+
+static Uint64 now_ns(void)
+{
+    static Uint64 freq = 0;
+    if (!freq)
+        freq = SDL_GetPerformanceFrequency();
+
+    Uint64 c = SDL_GetPerformanceCounter();
+    return (c / freq) * 1000000000ull + (c % freq) * 1000000000ull / freq;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    Uint64 x = *(const Uint64 *)a, y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *scene, const char *stage, Uint64 *samples, int n)
+{
+    qsort(samples, n, sizeof(*samples), compare_u64);
+
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += samples[i];
+
+    printf("%-14s %-8s %10.0f %10llu %10llu %10llu %10llu\n", scene, stage, sum / n,
+           (unsigned long long)samples[n/2],
+           (unsigned long long)samples[n*90/100],
+           (unsigned long long)samples[n*99/100],
+           (unsigned long long)samples[n-1]);
+}
+
+static void bench_frame(Scene *scene, Uint64 *times)
+{
+    Uint64 t0 = now_ns();
+
+    // the sim runs inline, exactly one fixed step per frame
+    sim_tick();
+    Uint64 ts = now_ns();
+
+    SDL_SetRenderDrawColor(renderer, 18, 18, 18, 255);
+    SDL_RenderClear(renderer);
+
+    // same order as draw_scene(), the dynamic flush is counted as draw
+    Uint64 t1 = now_ns();
+    comp_static(scene);
+    draw_scene_content(scene);
+    Uint64 t2 = now_ns();
+    comp_flush();
+    Uint64 t3 = now_ns();
+    draw_scene_plots(scene);
+    comp_widgets(scene);
+    Uint64 t4 = now_ns();
+    dl_flush();
+    Uint64 t5 = now_ns();
+    text_flush();
+    SDL_RenderPresent(renderer);
+    Uint64 t6 = now_ns();
+
+    times[STAGE_SIM] = ts - t0;
+    times[STAGE_SCENE] = t2 - t1;
+    times[STAGE_WIDGETS] = t4 - t3;
+    times[STAGE_DRAW] = (t3 - t2) + (t5 - t4);
+    times[STAGE_TEXT] = t6 - t5;
+    times[STAGE_FRAME] = t6 - t0;
+
+    prof_frame_end();
+}
+
+static void bench_scenes(int frames)
+{
+    Uint64 *samples[STAGE_END];
+    for (int s = 0; s < STAGE_END; s++) {
+        samples[s] = malloc(sizeof(Uint64) * frames);
+        if (!samples[s]) {
+            fprintf(stderr, "bench: out of memory\n");
+            exit(1);
+        }
+    }
+
+    printf("%-14s %-8s %10s %10s %10s %10s %10s   [ns/frame]\n",
+           "scene", "stage", "mean", "p50", "p90", "p99", "max");
+
+    for (int i = 0; i < SCENE_END; i++) {
+        Scene *scene = &SCENES[i];
+        SIM_STATE.sel_scene = scene;
+        sim_select_scene(scene);
+
+        Uint64 times[STAGE_END];
+        for (int f = 0; f < BENCH_WARMUP_FRAMES; f++)
+            bench_frame(scene, times);
+
+        for (int f = 0; f < frames; f++) {
+            bench_frame(scene, times);
+            for (int s = 0; s < STAGE_END; s++)
+                samples[s][f] = times[s];
+        }
+
+        for (int s = 0; s < STAGE_END; s++)
+            report(scene->name, stage_names[s], samples[s], frames);
+    }
+
+    for (int s = 0; s < STAGE_END; s++)
+        free(samples[s]);
+
+    SIM_STATE.sel_scene = &SCENES[SCENE_MENU];
+    sim_select_scene(SIM_STATE.sel_scene);
+
+    FrameCacheStats cache;
+    framecache_stats(&cache);
+    printf("\nframe cache: %llu hits, %llu misses, %llu entries, %llu kB\n",
+           (unsigned long long)cache.hits, (unsigned long long)cache.misses,
+           (unsigned long long)cache.entries, (unsigned long long)cache.bytes / 1024);
+}
+
+// mean draw and frame time of every scene under both drawlist backends
+static void bench_backends(int frames)
+{
+    DrawBackend selected = dl_backend();
+
+    printf("\n%-14s %-8s %10s %10s   [ns/frame, mean]\n", "scene", "backend", "draw", "frame");
+
+    for (int i = 0; i < SCENE_END; i++) {
+        Scene *scene = &SCENES[i];
+        SIM_STATE.sel_scene = scene;
+        sim_select_scene(scene);
+
+        for (int b = 0; b < DL_BACKEND_END; b++) {
+            dl_set_backend(b);
+            // the cached layers are drawn by the backend too
+            comp_invalidate();
+
+            Uint64 times[STAGE_END];
+            for (int f = 0; f < BENCH_WARMUP_FRAMES; f++)
+                bench_frame(scene, times);
+
+            double draw = 0, frame = 0;
+            for (int f = 0; f < frames; f++) {
+                bench_frame(scene, times);
+                draw += times[STAGE_DRAW];
+                frame += times[STAGE_FRAME];
+            }
+
+            printf("%-14s %-8s %10.0f %10.0f\n", scene->name, dl_backend_name(b),
+                   draw / frames, frame / frames);
+        }
+    }
+
+    dl_set_backend(selected);
+    comp_invalidate();
+
+    SIM_STATE.sel_scene = &SCENES[SCENE_MENU];
+    sim_select_scene(SIM_STATE.sel_scene);
+}
+
+#define KERNEL_POINTS 1400
+#define KERNEL_ROUNDS 2000
+
+// the sampling kernels, timed and checked against libm
+static void bench_kernels(void)
+{
+    static float out[KERNEL_POINTS], xs[KERNEL_POINTS], pts_out[KERNEL_POINTS];
+    const double dx = 1.0/50, period = 5, lambda = 30, amplitude = 2;
+    volatile double sink = 0;
+    double err_batch = 0, err_phasor = 0, err_points = 0;
+
+    Uint64 t0 = now_ns();
+    for (int r = 0; r < KERNEL_ROUNDS; r++)
+        for (int i = 0; i < KERNEL_POINTS; i++)
+            sink += wave_func(r*0.1, i*dx, period, lambda, amplitude, 0);
+    Uint64 t1 = now_ns();
+
+    for (int r = 0; r < KERNEL_ROUNDS; r++) {
+        wave_func_batch(out, KERNEL_POINTS, r*0.1, 0, dx, period, lambda, amplitude, 0);
+        sink += out[r % KERNEL_POINTS];
+    }
+    Uint64 t2 = now_ns();
+
+    WavePhasor phasor = {0};
+    wave_phasor_set(&phasor, 0.1, dx, period, lambda, amplitude, 0);
+    for (int r = 0; r < KERNEL_ROUNDS; r++) {
+        wave_phasor_step(&phasor);
+        wave_phasor_sample(&phasor, out, KERNEL_POINTS, 0);
+        sink += out[r % KERNEL_POINTS];
+    }
+    Uint64 t3 = now_ns();
+
+    // the same grid through the kernel for arbitrary points
+    for (int i = 0; i < KERNEL_POINTS; i++)
+        xs[i] = i*dx;
+    for (int r = 0; r < KERNEL_ROUNDS; r++) {
+        wave_func_points(pts_out, xs, KERNEL_POINTS, r*0.1, period, lambda, amplitude, 0);
+        sink += pts_out[r % KERNEL_POINTS];
+    }
+    Uint64 t4 = now_ns();
+
+    // accuracy at the state both samplers ended in
+    double t_end = KERNEL_ROUNDS*0.1;
+    for (int i = 0; i < KERNEL_POINTS; i++)
+        err_phasor = fmax(err_phasor, fabs(out[i] - wave_func(t_end, i*dx, period, lambda, amplitude, 0)));
+
+    wave_func_batch(out, KERNEL_POINTS, t_end, 0, dx, period, lambda, amplitude, 0);
+    for (int i = 0; i < KERNEL_POINTS; i++)
+        err_batch = fmax(err_batch, fabs(out[i] - wave_func(t_end, i*dx, period, lambda, amplitude, 0)));
+
+    // the points kernel's last round was one step earlier
+    for (int i = 0; i < KERNEL_POINTS; i++)
+        err_points = fmax(err_points, fabs(pts_out[i] - wave_func(t_end - 0.1, xs[i], period, lambda, amplitude, 0)));
+
+    double n = (double)KERNEL_ROUNDS * KERNEL_POINTS;
+    printf("\n%-14s %10s %12s   [ns/sample]\n", "kernel", "time", "max err");
+    printf("%-14s %10.2f %12s\n", "libm", (t1 - t0) / n, "-");
+    printf("%-14s %10.2f %12.2e\n", wave_kernel_name(), (t2 - t1) / n, err_batch);
+    printf("%-14s %10.2f %12.2e\n", "phasor", (t3 - t2) / n, err_phasor);
+    printf("%-14s %10.2f %12.2e\n", "points", (t4 - t3) / n, err_points);
+}
+
+#define STENCIL_2D 2048
+#define STENCIL_1D (1 << 22)
+#define STENCIL_STEPS 50
+
+static void bench_stencil_grid(const char *name, int w, int h)
+{
+    FdmGrid g;
+    fdm_init(&g, w, h);
+    fdm_pulse(&g, w / 2, h / 2, 16, 1);
+
+    for (int b = 0; b < FDM_BOUNDARY_END; b++) {
+        Uint64 t0 = now_ns();
+        for (int i = 0; i < STENCIL_STEPS; i++)
+            fdm_step(&g, 0.5, 0.001, b);
+        Uint64 t1 = now_ns();
+
+        double cells = (double)w * h * STENCIL_STEPS;
+        printf("%-14s %-10s %10.1f %10.3f\n", name, fdm_boundary_name(b),
+               cells / ((t1 - t0) / 1e3), (t1 - t0) / cells);
+    }
+
+    fdm_free(&g);
+}
+
+// stencil throughput of the finite difference solver at its largest sizes
+static void bench_stencil(void)
+{
+    printf("\n%-14s %-10s %10s %10s   [%d threads]\n",
+           "stencil", "boundary", "Mcell/s", "ns/cell", pool_threads());
+
+    bench_stencil_grid("1d 4M", STENCIL_1D, 1);
+    bench_stencil_grid("2d 2048^2", STENCIL_2D, STENCIL_2D);
+}
+
+#define FOURIER_ROUNDS 20
+
+/*
+ * Inverse FFT synthesis against summing every harmonic at every sample, and
+ * the whole per frame cost of the scene: synthesis plus the curve reduction.
+ */
+static void bench_fourier(void)
+{
+    static double a[FOURIER_MAX_HARMONICS + 1], p[FOURIER_MAX_HARMONICS + 1];
+    static float y_fft[FOURIER_N], y_direct[FOURIER_N];
+    static float x_curve[FOURIER_N], y_curve[FOURIER_N];
+    int vertices = 0;
+    const int harmonics = DEFAULT_FOURIER_HARMONICS;
+    double err = 0;
+
+    fourier_preset(a, p, FOURIER_SQUARE);
+
+    Uint64 t0 = now_ns();
+    for (int r = 0; r < FOURIER_ROUNDS; r++)
+        fourier_synth_fft(y_fft, a, p, harmonics, r*0.1);
+    Uint64 t1 = now_ns();
+    for (int r = 0; r < FOURIER_ROUNDS; r++)
+        fourier_synth_direct(y_direct, a, p, harmonics, r*0.1);
+    Uint64 t2 = now_ns();
+    for (int r = 0; r < FOURIER_ROUNDS; r++) {
+        fourier_synth_fft(y_fft, a, p, harmonics, r*0.1);
+        vertices = fourier_curve(y_fft, 0.25f, x_curve, y_curve);
+    }
+    Uint64 t3 = now_ns();
+
+    // the last curve round left y_fft at the last direct sum time
+    for (int i = 0; i < FOURIER_N; i++)
+        err = fmax(err, fabs(y_fft[i] - y_direct[i]));
+
+    printf("\n%-14s %10s %12s   [us/frame, %d harmonics, %d samples]\n",
+           "fourier", "time", "max err", harmonics, FOURIER_N);
+    printf("%-14s %10.1f %12.2e\n", "inverse fft", (t1 - t0) / 1e3 / FOURIER_ROUNDS, err);
+    printf("%-14s %10.1f %12s\n", "direct sum", (t2 - t1) / 1e3 / FOURIER_ROUNDS, "-");
+    printf("%-14s %10.1f %12s   %d vertices\n", "fft + curve", (t3 - t2) / 1e3 / FOURIER_ROUNDS, "-", vertices);
+}
+
+void bench_run(int frames)
+{
+    if (frames < 1)
+        frames = BENCH_DEFAULT_FRAMES;
+
+    bench_scenes(frames);
+    bench_backends(frames);
+    bench_kernels();
+    bench_stencil();
+    bench_fourier();
+}
@@ -0,0 +1,8 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#define BENCH_DEFAULT_FRAMES 500
+
+void bench_run(int frames);
+
+#endif /* _BENCH_H */
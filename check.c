@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <math.h>
+
+#include "check.h"
+#include "wave.h"
+
+#define CHECK_MAX_N 1024
+#define CHECK_TAIL_N 37 // every length up to this, so each tail length occurs
+
+// the wave scenes draw 50 pixels per unit (SCALE in draw.c) at 0.1 per step
+#define CHECK_PIXEL (1.0/50)
+#define CHECK_PHASOR_DT 0.1
+#define CHECK_PHASOR_STEPS 144000 // t reaches 14400, 4 h counted in seconds
+#define CHECK_PHASOR_EVERY 4800
+
+static int failures = 0;
+
+static void report(const char *name, double err, double bound)
+{
+    int ok = err <= bound;
+    printf("%-16s max err %10.3e   bound %10.3e   %s\n", name, err, bound, ok ? "ok" : "FAIL");
+
+    if (!ok)
+        failures++;
+}
+
+/* wave_func_batch() against wave_func() at long running times and every tail length. */
+static void check_batch(void)
+{
+    static float out[CHECK_MAX_N];
+    const double period = 5, amplitude = 2;
+    const double lambdas[] = { 5, 30, 200 };
+    double err = 0;
+
+    for (int l = 0; l < 3; l++) {
+        for (double t = 0; t < 1e5; t = t*3 + 0.7) {
+            for (int n = 1; n <= CHECK_TAIL_N; n++) {
+                double x0 = 10, dx = 1.0/50;
+                wave_func_batch(out, n, t, x0, dx, period, lambdas[l], amplitude, 0.3);
+                for (int i = 0; i < n; i++)
+                    err = fmax(err, fabs(out[i] - wave_func(t, x0 + i*dx, period, lambdas[l], amplitude, 0.3)));
+            }
+
+            wave_func_batch(out, CHECK_MAX_N, t, 0, 1.3, period, lambdas[l], amplitude, 0.3);
+            for (int i = 0; i < CHECK_MAX_N; i++)
+                err = fmax(err, fabs(out[i] - wave_func(t, i*1.3, period, lambdas[l], amplitude, 0.3)));
+        }
+    }
+
+    report(wave_kernel_name(), err, WAVE_BATCH_MAX_ERR * amplitude);
+}
+
+/*
+ * wave_radial_accum() against the same sum in double, with the rows far
+ * from the source so the scalar tails see large arguments.
+ */
+static void check_radial(void)
+{
+    static float acc[CHECK_MAX_N];
+    const double period = 5, lambda = 40;
+    double err = 0, bound = 0;
+
+    for (double t = 0; t < 1e5; t = t*3 + 0.7) {
+        for (int n = 1; n <= CHECK_TAIL_N; n++) {
+            for (int y = 0; y < 1800; y += 450) {
+                double x0 = 1400 - n;
+                for (int i = 0; i < n; i++)
+                    acc[i] = 0;
+
+                wave_radial_accum(acc, n, x0, y, 0, 0, t, period, lambda, 0.3);
+                for (int i = 0; i < n; i++) {
+                    double r = sqrt((x0 + i)*(x0 + i) + (double)y*y);
+                    double ref = sin(2*PI*t/period + 0.3 - 2*PI*r/lambda);
+                    err = fmax(err, fabs(acc[i] - ref));
+                    bound = fmax(bound, WAVE_PHASE_MAX_ERR(2*PI*r/lambda));
+                }
+            }
+        }
+    }
+
+    report("radial", err, bound);
+}
+
+/* wave_func_points() over the window width at every tail length. */
+static void check_points(void)
+{
+    static float x[CHECK_MAX_N], out[CHECK_MAX_N];
+    const double period = 5, amplitude = 30;
+    const double lambdas[] = { 5, 50, 600 };
+    double err = 0, bound = 0;
+
+    for (int l = 0; l < 3; l++) {
+        for (double t = 0; t < 1e5; t = t*3 + 0.7) {
+            for (int n = 1; n <= CHECK_TAIL_N; n++) {
+                for (int i = 0; i < n; i++)
+                    x[i] = 1400 - n + i + 0.37f;
+
+                wave_func_points(out, x, n, t, period, lambdas[l], amplitude, 0.3);
+                for (int i = 0; i < n; i++) {
+                    err = fmax(err, fabs(out[i] - wave_func(t, x[i], period, lambdas[l], amplitude, 0.3)));
+                    bound = fmax(bound, amplitude * WAVE_PHASE_MAX_ERR(2*PI*x[i]/lambdas[l]));
+                }
+            }
+        }
+    }
+
+    report("points", err, bound);
+}
+
+/*
+ * WavePhasor after hours of steps against wave_func() at the same t, over
+ * the window width at the largest amplitude the slider allows. It has to
+ * stay within a pixel of the exact curve.
+ */
+static void check_phasor(void)
+{
+    static float out[CHECK_MAX_N + 400];
+    const int n = CHECK_MAX_N + 400;
+    const double period = 5, lambda = 30, amplitude = 5, x0 = 10 * CHECK_PIXEL;
+    double err = 0;
+
+    WavePhasor w = {0};
+    wave_phasor_set(&w, CHECK_PHASOR_DT, CHECK_PIXEL, period, lambda, amplitude, 0.3);
+
+    for (int s = 1; s <= CHECK_PHASOR_STEPS; s++) {
+        wave_phasor_step(&w);
+        if (s % CHECK_PHASOR_EVERY)
+            continue;
+
+        wave_phasor_sample(&w, out, n, x0);
+        for (int i = 0; i < n; i++)
+            err = fmax(err, fabs(out[i] - wave_func(w.t, x0 + i*CHECK_PIXEL, period, lambda, amplitude, 0.3)));
+    }
+
+    report("phasor 4h", err, CHECK_PIXEL);
+}
+
+int check_run(void)
+{
+    failures = 0;
+
+    check_batch();
+    check_radial();
+    check_points();
+    check_phasor();
+
+    if (failures)
+        fprintf(stderr, "check: %d failed\n", failures);
+
+    return failures;
+}
@@ -0,0 +1,16 @@
+#ifndef _CHECK_H
+#define _CHECK_H
+
+/*
+ * Accuracy checks for the numeric kernels, run with --check (make check).
+ * Every kernel is compared against the libm based reference over the
+ * argument ranges the scenes use and over lengths that leave a scalar tail
+ * behind the SIMD blocks. A check fails when its largest error exceeds the
+ * bound documented next to the kernel. Nothing is rendered and no SDL
+ * subsystem is needed.
+ */
+
+// returns the number of failed checks
+int check_run(void);
+
+#endif /* _CHECK_H */
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+#include "comp.h"
+#include "drawlist.h"
+#include "text.h"
+#include "config.h"
+
+extern SDL_Renderer *renderer;
+
+typedef enum CompLayer {
+    COMP_STATIC,
+    COMP_WIDGETS,
+    COMP_END,
+} CompLayer;
+
+typedef struct CompCache {
+    SDL_Texture *texture;
+    Scene *scene;   // scene the texture was drawn for, NULL when dirty
+} CompCache;
+
+static CompCache layers[COMP_END];
+static int supported = -1;
+
+static bool comp_supported(void)
+{
+    if (supported < 0)
+        supported = SDL_RenderTargetSupported(renderer);
+
+    return supported;
+}
+
+static void comp_texture(CompCache *layer)
+{
+    if (layer->texture)
+        return;
+
+    layer->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                       CONFIG_WINDOW_WIDTH, CONFIG_WINDOW_HEIGHT);
+    if (!layer->texture) {
+        // not fatal, keep drawing everything directly
+        fprintf(stderr, "sdl error: comp: CreateTexture: %s\n", SDL_GetError());
+        supported = 0;
+        return;
+    }
+
+    SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_BLEND);
+}
+
+/* Redraws the layer if it is stale, returns false if it can't be cached. */
+static bool comp_update(CompLayer id, Scene *scene, void (*drawfn)(Scene *scene))
+{
+    CompCache *layer = &layers[id];
+
+    if (!comp_supported())
+        return false;
+
+    comp_texture(layer);
+    if (!layer->texture)
+        return false;
+
+    if (layer->scene == scene)
+        return true;
+
+    // the layer gets its own flush, anything queued so far belongs below it
+    dl_flush();
+    text_flush();
+
+    SDL_SetRenderTarget(renderer, layer->texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    drawfn(scene);
+    dl_flush();
+    text_flush();
+
+    SDL_SetRenderTarget(renderer, NULL);
+    layer->scene = scene;
+
+    return true;
+}
+
+static void draw_static(Scene *scene)
+{
+    dl_layer(DL_LAYER_SCENE);
+    scene->staticfn();
+}
+
+void comp_static(Scene *scene)
+{
+    if (!scene->staticfn)
+        return;
+
+    if (comp_update(COMP_STATIC, scene, draw_static))
+        SDL_RenderCopy(renderer, layers[COMP_STATIC].texture, NULL, NULL);
+    else
+        draw_static(scene);
+}
+
+void comp_flush(void)
+{
+    // without cached layers everything goes out in the final flush
+    if (!comp_supported())
+        return;
+
+    dl_flush();
+    text_flush();
+}
+
+void comp_widgets(Scene *scene)
+{
+    if (comp_update(COMP_WIDGETS, scene, draw_scene_widgets))
+        SDL_RenderCopy(renderer, layers[COMP_WIDGETS].texture, NULL, NULL);
+    else
+        draw_scene_widgets(scene);
+}
+
+void comp_invalidate(void)
+{
+    for (int i = 0; i < COMP_END; i++)
+        layers[i].scene = NULL;
+}
+
+void comp_invalidate_widgets(void)
+{
+    layers[COMP_WIDGETS].scene = NULL;
+}
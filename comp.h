@@ -0,0 +1,22 @@
+#ifndef _COMP_H
+#define _COMP_H
+
+#include "draw.h"
+
+/*
+ * Layered compositor. A scene's static content (Scene.staticfn) and its
+ * widgets are rendered into their own target textures and only redrawn when
+ * they are invalidated: on scene switch, on slider changes for the widget
+ * layer, or when the renderer lost its targets. Every frame then copies the
+ * static layer, draws the animated content on top and copies the widget
+ * layer over it. Renderers without target support draw everything directly.
+ */
+
+void comp_static(Scene *scene);
+void comp_flush(void);
+void comp_widgets(Scene *scene);
+
+void comp_invalidate(void);
+void comp_invalidate_widgets(void);
+
+#endif /* _COMP_H */
@@ -3,7 +3,7 @@
 
 #define CONFIG_WINDOW_WIDTH 1400
 #define CONFIG_WINDOW_HEIGHT 900
-#define CONFIG_MAX_WIDGETS 32
+#define CONFIG_MAX_WIDGETS 256
 
 #define CONFIG_FONT_SIZE_SMALL 25
 #define CONFIG_FONT_SIZE 48
@@ -12,4 +12,29 @@
 #define CONFIG_FPS 50
 #define CONFIG_FPS_DELTA (1000/CONFIG_FPS)
 
+#define CONFIG_PACING_SPIN_US 2000
+#define CONFIG_PACING_MAX_SKIP 2
+
+#define CONFIG_SIM_HZ 50
+#define CONFIG_SIM_MAX_CATCHUP 5
+
+#ifndef CONFIG_POOL_MAX_THREADS
+#define CONFIG_POOL_MAX_THREADS 16
+#endif
+
+#define CONFIG_FDM_GRID 512
+
+#define CONFIG_FRAMECACHE_BYTES (4 << 20)
+
+#define CONFIG_GOV_MAX_KNOBS 4
+#define CONFIG_GOV_HIGH 0.9
+#define CONFIG_GOV_LOW 0.5
+
+#ifndef CONFIG_PROFILER
+#define CONFIG_PROFILER 1
+#endif
+#define CONFIG_PROF_HISTORY 240
+#define CONFIG_PROF_TRACE_FRAMES 300
+#define CONFIG_PROF_MAX_EVENTS (1 << 18)
+
 #endif /* _CONFIG_H */
@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <limits.h>
+
+#include <SDL2/SDL.h>
+
+#include "doppler.h"
+#include "drawlist.h"
+#include "config.h"
+#include "audio.h"
+#include "sim.h"
+
+/*
+ * Doppler engine: any number of sources moving with their own 2D velocity,
+ * each emitting a circular wavefront every DOPPLER_LAMBDA ticks. Fronts live
+ * in a packed structure-of-arrays pool, a front that faded out or grew past
+ * every corner of the viewport is recycled by moving the last live front
+ * into its slot. Only fronts that intersect the viewport make it into the
+ * snapshot.
+ */
+
+#define DOPPLER_LAMBDA 45
+#define DOPPLER_FADE 1
+
+#define DP_SRC_Y (CONFIG_WINDOW_HEIGHT/2)
+
+#define DP_LISTENER_X (CONFIG_WINDOW_WIDTH/2)
+#define DP_LISTENER_Y (CONFIG_WINDOW_HEIGHT/2)
+
+// emitted tone, what the listener hears is scaled by the rate fronts arrive at
+#define DP_AUDIO_HZ 440
+#define DP_AUDIO_AMP 0.3f
+#define DP_AUDIO_NEAR 150
+
+int DOPPLER_V = DEFAULT_DOPPLER_V;
+int DOPPLER_WAVE_SPEED = DEFAULT_DOPPLER_WAVE_SPEED;
+int DOPPLER_SOURCES = DEFAULT_DOPPLER_SOURCES;
+int DOPPLER_GOV_MIN_ALPHA = 0; // the governor drops fainter fronts from the snapshot
+
+Plot DOPPLER_PLOT = {
+    .history = DP_PLOT_HISTORY,
+    .rate = CONFIG_SIM_HZ,
+    .r = 255,
+};
+
+typedef struct DopplerSources {
+    // direction and relative speed, scaled by DOPPLER_V every tick
+    float x[DOPPLER_MAX_SOURCES], y[DOPPLER_MAX_SOURCES];
+    float vx[DOPPLER_MAX_SOURCES], vy[DOPPLER_MAX_SOURCES];
+    int emit_offset[DOPPLER_MAX_SOURCES];
+} DopplerSources;
+
+typedef struct DopplerFronts {
+    int count;
+    float x[DOPPLER_MAX_FRONTS], y[DOPPLER_MAX_FRONTS], r[DOPPLER_MAX_FRONTS];
+    float a[DOPPLER_MAX_FRONTS];
+    int src[DOPPLER_MAX_FRONTS];
+    bool hit[DOPPLER_MAX_FRONTS];
+} DopplerFronts;
+
+static DopplerSources sources;
+static DopplerFronts fronts;
+static bool sources_ready = false;
+
+static PlotFeed freq_feed;
+static int prev_hit_t = -1;
+static double listener_ratio = 1;
+static int doppler_t = 0;
+
+static float frand(unsigned *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (float)((*seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+/*
+ * Source 0 is the classic one moving right along the listener's axis, the
+ * others get a fixed pseudo random position, heading and speed so runs are
+ * reproducible.
+ */
+static void sources_init(void)
+{
+    unsigned seed = 0x5eed;
+
+    sources.x[0] = 0;
+    sources.y[0] = DP_SRC_Y;
+    sources.vx[0] = 1;
+    sources.vy[0] = 0;
+    sources.emit_offset[0] = 0;
+
+    for (int i = 1; i < DOPPLER_MAX_SOURCES; i++) {
+        float heading = frand(&seed) * 2 * (float)M_PI;
+        float speed = 0.3f + 0.7f * frand(&seed);
+
+        sources.x[i] = frand(&seed) * CONFIG_WINDOW_WIDTH;
+        sources.y[i] = frand(&seed) * CONFIG_WINDOW_HEIGHT;
+        sources.vx[i] = cosf(heading) * speed;
+        sources.vy[i] = sinf(heading) * speed;
+        sources.emit_offset[i] = (int)(frand(&seed) * DOPPLER_LAMBDA);
+    }
+
+    sources_ready = true;
+}
+
+static float wrap(float v, float max)
+{
+    v = fmodf(v, max);
+    return v < 0 ? v + max : v;
+}
+
+static void fronts_emit(float x, float y, int src)
+{
+    // a full pool drops new fronts rather than growing
+    if (fronts.count == DOPPLER_MAX_FRONTS)
+        return;
+
+    int i = fronts.count++;
+    fronts.x[i] = x;
+    fronts.y[i] = y;
+    fronts.r[i] = 1;
+    fronts.a[i] = 255;
+    fronts.src[i] = src;
+    fronts.hit[i] = false;
+}
+
+static void fronts_recycle(int i)
+{
+    int last = --fronts.count;
+
+    fronts.x[i] = fronts.x[last];
+    fronts.y[i] = fronts.y[last];
+    fronts.r[i] = fronts.r[last];
+    fronts.a[i] = fronts.a[last];
+    fronts.src[i] = fronts.src[last];
+    fronts.hit[i] = fronts.hit[last];
+}
+
+static float max_f(float a, float b)
+{
+    return a > b ? a : b;
+}
+
+// distance from (x, y) to the viewport corner furthest away
+static float viewport_far(float x, float y)
+{
+    float dx = max_f(x, CONFIG_WINDOW_WIDTH - x);
+    float dy = max_f(y, CONFIG_WINDOW_HEIGHT - y);
+    return sqrtf(dx*dx + dy*dy);
+}
+
+// distance from (x, y) to the closest viewport point, 0 inside
+static float viewport_near(float x, float y)
+{
+    float dx = max_f(max_f(-x, x - CONFIG_WINDOW_WIDTH), 0);
+    float dy = max_f(max_f(-y, y - CONFIG_WINDOW_HEIGHT), 0);
+    return sqrtf(dx*dx + dy*dy);
+}
+
+static void listener_check(int t)
+{
+    for (int i = 0; i < fronts.count; i++) {
+        // only the primary source feeds the observed frequency
+        if (fronts.src[i] != 0 || fronts.hit[i])
+            continue;
+
+        float dx = DP_LISTENER_X - fronts.x[i];
+        float dy = DP_LISTENER_Y - fronts.y[i];
+        float p = sqrtf(dx*dx + dy*dy);
+        if (fabsf(p - fronts.r[i]) >= DOPPLER_WAVE_SPEED)
+            continue;
+
+        fronts.hit[i] = true;
+
+        if (prev_hit_t > 0 && t > prev_hit_t) {
+            listener_ratio = (double)DOPPLER_LAMBDA / (t - prev_hit_t);
+        }
+
+        prev_hit_t = t;
+    }
+}
+
+#define DP_OBSERVE_FRONTS 32
+
+/*
+ * Reduced run of the scene for parameter sweeps: only the primary source,
+ * moving along the listener's axis at speed v with fronts growing by c per
+ * tick. DP_OBSERVE_FRONTS fronts are emitted on either side of the pass, each
+ * reaches the listener at the tick listener_check() would fire for it, and
+ * the mean interval between arrivals gives the observed frequency relative to
+ * the emitted one while approaching and receding (negative past Mach 1, the
+ * fronts arrive in reverse order). Fading is ignored. Reentrant.
+ */
+static long observe_arrival(long te, double p, double c)
+{
+    // at tick te + j the front has radius 1 + (j + 1) c, it hits within c of p
+    long j = (long)floor((p - 1) / c) - 1;
+    return te + (j > 0 ? j : 0);
+}
+
+void doppler_observe(double v, double c, double *approach, double *recede)
+{
+    long arrival[2 * DP_OBSERVE_FRONTS];
+
+    for (int k = 0; k < 2 * DP_OBSERVE_FRONTS; k++) {
+        // the source passes the listener at tick 0, halfway between two emissions
+        long te = (long)(k - DP_OBSERVE_FRONTS) * DOPPLER_LAMBDA + DOPPLER_LAMBDA / 2;
+        arrival[k] = observe_arrival(te, fabs(v * te), c);
+    }
+
+    double span = DP_OBSERVE_FRONTS - 1;
+    *approach = DOPPLER_LAMBDA * span / (arrival[DP_OBSERVE_FRONTS - 1] - arrival[0]);
+    *recede = DOPPLER_LAMBDA * span / (arrival[2 * DP_OBSERVE_FRONTS - 1] - arrival[DP_OBSERVE_FRONTS]);
+}
+
+void sim_scene_doppler()
+{
+    if (!sources_ready)
+        sources_init();
+
+    doppler_t = (doppler_t + 1) % INT_MAX;
+    int t = doppler_t;
+    int nsources = DOPPLER_SOURCES;
+
+    // move and emit
+    for (int i = 0; i < nsources; i++) {
+        sources.x[i] = wrap(sources.x[i] + sources.vx[i] * DOPPLER_V, CONFIG_WINDOW_WIDTH);
+        sources.y[i] = wrap(sources.y[i] + sources.vy[i] * DOPPLER_V, CONFIG_WINDOW_HEIGHT);
+
+        if ((t + sources.emit_offset[i]) % DOPPLER_LAMBDA == 0)
+            fronts_emit(sources.x[i], sources.y[i], i);
+    }
+
+    // grow and fade, plain loops over the arrays so they vectorize
+    float speed = DOPPLER_WAVE_SPEED;
+    for (int i = 0; i < fronts.count; i++)
+        fronts.r[i] += speed;
+    for (int i = 0; i < fronts.count; i++)
+        fronts.a[i] -= DOPPLER_FADE;
+
+    listener_check(t);
+
+    // silent until the first front reaches the listener, louder while the source is close
+    if (prev_hit_t > 0) {
+        float dx = sources.x[0] - DP_LISTENER_X, dy = sources.y[0] - DP_LISTENER_Y;
+        float near = DP_AUDIO_NEAR / fmaxf(sqrtf(dx*dx + dy*dy), 1);
+        audio_tone(DP_AUDIO_HZ * listener_ratio, DP_AUDIO_AMP * fminf(near, 1));
+        plot_feed_push(&freq_feed, DP_AUDIO_HZ * listener_ratio);
+    }
+
+    // recycle faded fronts and fronts that contain the whole viewport
+    for (int i = 0; i < fronts.count; ) {
+        if (fronts.a[i] <= 0 || fronts.r[i] > viewport_far(fronts.x[i], fronts.y[i]))
+            fronts_recycle(i);
+        else
+            i++;
+    }
+}
+
+void snap_scene_doppler(void *snap)
+{
+    DopplerSnap *ds = snap;
+
+    if (!sources_ready)
+        sources_init();
+
+    ds->nsources = DOPPLER_SOURCES;
+    for (int i = 0; i < ds->nsources; i++) {
+        ds->src_x[i] = sources.x[i];
+        ds->src_y[i] = sources.y[i];
+    }
+
+    // cull fronts that don't reach into the viewport yet
+    int n = 0;
+    for (int i = 0; i < fronts.count; i++) {
+        if (fronts.r[i] < viewport_near(fronts.x[i], fronts.y[i]) || fronts.a[i] < DOPPLER_GOV_MIN_ALPHA)
+            continue;
+
+        ds->x[n] = fronts.x[i];
+        ds->y[n] = fronts.y[i];
+        ds->r[n] = fronts.r[i];
+        ds->a[n] = (unsigned char)fronts.a[i];
+        n++;
+    }
+    ds->nfronts = n;
+
+    ds->freq = freq_feed;
+}
+
+void draw_scene_doppler(const void *snap)
+{
+    const DopplerSnap *ds = snap;
+
+    for (int i = 0; i < ds->nfronts; i++)
+        dl_circle(ds->x[i], ds->y[i], ds->r[i], 255, 255, 255, ds->a[i]);
+
+    for (int i = 1; i < ds->nsources; i++)
+        dl_filled_circle(ds->src_x[i], ds->src_y[i], 8, 255, 120, 0, 255);
+    dl_filled_circle(ds->src_x[0], ds->src_y[0], 20, 255, 0, 0, 255); // source
+
+    plot_consume(&DOPPLER_PLOT, &ds->freq);
+}
+
+#define DP_GOV_ALPHA_STEP 64
+
+void knob_doppler_fronts(int level)
+{
+    sim_param_set_int(&DOPPLER_GOV_MIN_ALPHA, level * DP_GOV_ALPHA_STEP);
+}
+
+void draw_static_doppler(void)
+{
+    dl_filled_circle(DP_LISTENER_X, DP_LISTENER_Y, 20, 0, 255, 0, 255); // listener
+}
@@ -0,0 +1,52 @@
+#ifndef _DOPPLER_H
+#define _DOPPLER_H
+
+#include "config.h"
+
+#define DEFAULT_DOPPLER_V 1
+#define DEFAULT_DOPPLER_WAVE_SPEED 3
+#define DEFAULT_DOPPLER_SOURCES 1
+
+#define DOPPLER_MAX_SOURCES 512
+#define DOPPLER_MAX_FRONTS 8192
+
+extern int DOPPLER_V;
+extern int DOPPLER_WAVE_SPEED;
+extern int DOPPLER_SOURCES;
+extern int DOPPLER_GOV_MIN_ALPHA;
+
+#define DOPPLER_GOV_LEVELS 4
+
+#include "plot.h"
+
+// observed frequency plot, sampled every tick
+#define DP_PLOT_HISTORY (1 << 17)
+#define DP_PLOT_X1 (CONFIG_WINDOW_WIDTH-400)
+#define DP_PLOT_Y1 (CONFIG_WINDOW_HEIGHT-350)
+#define DP_PLOT_X2 (DP_PLOT_X1+300)
+#define DP_PLOT_Y2 (DP_PLOT_Y1+300)
+
+extern Plot DOPPLER_PLOT;
+
+typedef struct DopplerSnap {
+    int nsources;
+    float src_x[DOPPLER_MAX_SOURCES], src_y[DOPPLER_MAX_SOURCES];
+
+    // fronts that reach into the viewport, everything else is culled
+    int nfronts;
+    float x[DOPPLER_MAX_FRONTS], y[DOPPLER_MAX_FRONTS], r[DOPPLER_MAX_FRONTS];
+    unsigned char a[DOPPLER_MAX_FRONTS];
+
+    PlotFeed freq;
+} DopplerSnap;
+
+void doppler_observe(double v, double c, double *approach, double *recede);
+
+void sim_scene_doppler();
+void snap_scene_doppler(void *snap);
+void draw_scene_doppler(const void *snap);
+void draw_static_doppler(void);
+
+void knob_doppler_fronts(int level);
+
+#endif /* _DOPPLER_H */
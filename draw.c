@@ -1,13 +1,27 @@
 #include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_ttf.h>
 
 #include <math.h>
 #include <limits.h>
+#include <string.h>
+#include <stdbool.h>
 
 #include "draw.h"
+#include "text.h"
+#include "drawlist.h"
+#include "wave.h"
+#include "doppler.h"
+#include "field.h"
+#include "fdscene.h"
+#include "fourier.h"
+#include "medium.h"
 #include "config.h"
 #include "simstate.h"
+#include "sim.h"
+#include "prof.h"
+#include "comp.h"
+#include "framecache.h"
+#include "audio.h"
 
 extern SDL_Window *window;
 extern SDL_Renderer *renderer;
@@ -15,286 +29,497 @@ extern TTF_Font *font;
 extern TTF_Font *font_small;
 extern TTF_Font *font_huge;
 
-#define PI 3.14159265358f
-
-#define DEFAULT_TIME_STEP 0.1f
-#define DEFAULT_DOPPLER_V 1
-#define DEFAULT_DOPPLER_WAVE_SPEED 3
-#define DEFAULT_GLOB_AMPLITUDE 2.f
-#define DEFAULT_GLOB_LAMBDA 30.f
+#define DEFAULT_TIME_STEP 0.1
 #define DEFAULT_GLOB_PERIOD 5.f
-#define DEFAULT_GLOB_PHI 0.f
-#define DEFAULT_GLOB_WAVE_POINTS 1000
+#define DEFAULT_GLOB_TOLERANCE 0.25
 
 // global sim variables
 static double TIME_STEP = DEFAULT_TIME_STEP;
-static int DOPPLER_V = DEFAULT_DOPPLER_V;
-static int DOPPLER_WAVE_SPEED = DEFAULT_DOPPLER_WAVE_SPEED;
 static double GLOB_AMPLITUDE = DEFAULT_GLOB_AMPLITUDE;
 static double GLOB_LAMBDA = DEFAULT_GLOB_LAMBDA;
 static double GLOB_PERIOD = DEFAULT_GLOB_PERIOD;
 static double GLOB_PHI = DEFAULT_GLOB_PHI;
-static int GLOB_WAVE_POINTS = DEFAULT_GLOB_WAVE_POINTS;
+static double GLOB_TOLERANCE = DEFAULT_GLOB_TOLERANCE; // px
+
+// the governor's multipliers on GLOB_TOLERANCE, a coarser curve keeps fewer vertices
+static double BASIC_GOV_TOLERANCE = 1;
+static double INTERF_GOV_TOLERANCE = 1;
+
+/*
+ * Every scene is split in three parts: sim_* advances the scene's private
+ * state by one fixed step on the sim thread, snap_* copies what is needed for
+ * drawing into a snapshot, draw_* renders the latest snapshot.
+ */
 
-#define WAVE_STEP (CONFIG_WINDOW_WIDTH/GLOB_WAVE_POINTS)
+typedef struct MenuSnap {
+    double t;
+} MenuSnap;
 
-double wave_func(double t, double x,
-                 double period, double lambda,
-                 double amplitude, double phi)
+static double menu_t = 0;
+
+void sim_scene_menu()
 {
-    return amplitude * sin(2*PI*(t/period - x/lambda) + phi);
+    menu_t += DEFAULT_TIME_STEP;
 }
 
-void render_text(const char* text, int x, int y, TTF_Font *text_font)
+void snap_scene_menu(void *snap)
 {
-    SDL_Surface *text_surface;
+    ((MenuSnap *)snap)->t = menu_t;
+}
 
-    SDL_Color fgcolor = {255, 255, 255};
-    SDL_Color bgcolor = {18, 18, 18};
+void draw_scene_menu(const void *snap)
+{
+    double t = ((const MenuSnap *)snap)->t;
 
-    text_surface = TTF_RenderUTF8_Shaded(text_font, text, fgcolor, bgcolor);
-    
-    if(!text_surface) {
-        fprintf(stderr, "sdl_ttf error: %s", TTF_GetError());
-        exit(1);
+    dl_polyline_begin(255, 0, 0, 255);
+    for (int x = CONFIG_WINDOW_WIDTH/2-300; x < CONFIG_WINDOW_WIDTH/2+300; x += 1) {
+        int y = 50 * sin((double)x/50 + t);
+        dl_vertex(x, 200+y);
     }
+    dl_polyline_end();
+}
+
+void draw_static_menu(void)
+{
+    render_text("mechanical waves",
+                CONFIG_WINDOW_WIDTH/2-400, 10, font_huge);
+}
 
-    int txt_w = text_surface->w;
-    int txt_h = text_surface->h;
+#define SCALE 50
+#define START_POS 10
 
-    SDL_Rect text_rect = { .h = txt_h, .w = txt_w,
-                           .x = x, .y = y};
+// one dense sample per pixel, the snapshot keeps only what the tolerance needs
+#define WAVE_SAMPLES (CONFIG_WINDOW_WIDTH - START_POS)
 
-    SDL_Texture* text_texture = SDL_CreateTextureFromSurface(renderer, text_surface);
+typedef struct WaveCurve {
+    int n;
+    float x[WAVE_SAMPLES], y[WAVE_SAMPLES];
+} WaveCurve;
 
-    SDL_RenderCopy(renderer, text_texture, NULL, &text_rect);
+static float dense[WAVE_SAMPLES];
+static int keep[WAVE_SAMPLES];
 
-    SDL_FreeSurface(text_surface);
-    SDL_DestroyTexture(text_texture);
+static void curve_build(WaveCurve *curve, const float *y, double tolerance)
+{
+    curve->n = wave_simplify(y, WAVE_SAMPLES, SCALE, tolerance, keep);
+    for (int i = 0; i < curve->n; i++) {
+        curve->x[i] = START_POS + keep[i];
+        curve->y[i] = CONFIG_WINDOW_HEIGHT/2 + SCALE*y[keep[i]];
+    }
 }
 
-void draw_scene_menu()
+static void curve_draw(const WaveCurve *curve, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
-    static double t = 0;
-    t += DEFAULT_TIME_STEP;
-    int y = 50 * sin(((double)CONFIG_WINDOW_WIDTH/2-300)/50 + t);
-
-    for (int x = CONFIG_WINDOW_WIDTH/2-300; x < CONFIG_WINDOW_WIDTH/2+300; x += WAVE_STEP) {
-        int ny = 50 * sin((double)x/50 + t);
-        lineRGBA(renderer,
-                 x-WAVE_STEP, 200+y,
-                 x,           200+ny,
-                 255, 0, 0, 255);
-        y = ny;
+    dl_polyline_begin(r, g, b, a);
+    for (int i = 0; i < curve->n; i++)
+        dl_vertex(curve->x[i], curve->y[i]);
+    dl_polyline_end();
+}
+
+/*
+ * The basic and interference scenes are sampled with a WavePhasor per wave,
+ * stepped by the sim every tick. With fixed sliders and a time step that
+ * divides the period into a whole number of steps they also repeat exactly
+ * every period: step k and step k + period/TIME_STEP show the same phase.
+ * The curves are then cached under a hash of the parameters, the time at
+ * which the current time step was set and the step count modulo the steps
+ * per period, so after one period every snapshot is a copy out of the cache.
+ * The time flow sliders snap to such steps, a time step that is not one is
+ * sampled at the real t every tick. Any parameter change drops the cache:
+ * the sliders only post to the sim, which owns the cache and notices the
+ * change through the parameter hash in framecache_validate().
+ */
+#define WAVE_CACHE_MAX_BINS 4096
+
+typedef struct WaveClock {
+    double dt;          // time step of the current run of steps
+    double t_base;      // t when it was set
+    long long steps;    // steps taken since
+} WaveClock;
+
+static void wave_clock_step(WaveClock *clock, const WavePhasor *wave, double dt)
+{
+    if (dt != clock->dt) {
+        clock->dt = dt;
+        clock->t_base = wave->t;
+        clock->steps = 0;
     }
 
-    render_text("mechanical waves",
-                CONFIG_WINDOW_WIDTH/2-400, 10, font_huge);
+    clock->steps++;
 }
 
-void draw_scene_basic()
+/* Nearest time step that divides the period into at most WAVE_CACHE_MAX_BINS steps. */
+static double wave_step_snap(double dt, double period)
 {
-#define SCALE 50
-#define START_POS 10
-    static double t = 0;
-    t += TIME_STEP;
-    int y = (int)(SCALE *
-                  wave_func(t, (double)START_POS/SCALE, GLOB_PERIOD, GLOB_LAMBDA, GLOB_AMPLITUDE, 0.f));
+    if (dt <= 0)
+        return 0;
 
-    // animate basic wave equation
-    for (int x = START_POS+WAVE_STEP; x < CONFIG_WINDOW_WIDTH; x += WAVE_STEP) {
-        int ny = (int)(SCALE * wave_func(t, (double)x/SCALE, GLOB_PERIOD, GLOB_LAMBDA, GLOB_AMPLITUDE, 0.f));
-        lineRGBA(renderer,
-                 x-WAVE_STEP, CONFIG_WINDOW_HEIGHT/2+y,
-                 x, CONFIG_WINDOW_HEIGHT/2+ny,
-                 255, 0, 0, 255);
-        y = ny;
-    }
+    double steps = round(period / dt);
+    steps = steps < 1 ? 1 : steps > WAVE_CACHE_MAX_BINS ? WAVE_CACHE_MAX_BINS : steps;
+    return period / steps;
 }
 
-void draw_scene_interference()
+static void callback_time_step(void *data)
 {
-#define SCALE 50
-#define START_POS 10
-    static double t = 0;
-    t += TIME_STEP;
-
-    // ...
-
-    int red_y = (int)(SCALE * wave_func(t, (double)START_POS/SCALE,
-                                        DEFAULT_GLOB_PERIOD,
-                                        DEFAULT_GLOB_LAMBDA, DEFAULT_GLOB_AMPLITUDE, 0.f));
-
-    int blue_y = (int)(SCALE * wave_func(t, (double)START_POS/SCALE,
-                                         DEFAULT_GLOB_PERIOD,
-                                         DEFAULT_GLOB_LAMBDA, DEFAULT_GLOB_AMPLITUDE, GLOB_PHI));
-
-    int combined_y = blue_y + red_y;
-
-    for (int x = START_POS+WAVE_STEP; x < CONFIG_WINDOW_WIDTH; x += WAVE_STEP) {
-        int red_ny = (int)(SCALE * wave_func(t, (double)x/SCALE,
-                                             DEFAULT_GLOB_PERIOD,
-                                             DEFAULT_GLOB_LAMBDA, DEFAULT_GLOB_AMPLITUDE, 0.f));
-        lineRGBA(renderer,
-                 x-WAVE_STEP, CONFIG_WINDOW_HEIGHT/2+red_y,
-                 x, CONFIG_WINDOW_HEIGHT/2+red_ny,
-                 255, 0, 0, 100);
-        red_y = red_ny;
-
-        int blue_ny = (int)(SCALE * wave_func(t, (double)x/SCALE,
-                                              DEFAULT_GLOB_PERIOD,
-                                              DEFAULT_GLOB_LAMBDA, DEFAULT_GLOB_AMPLITUDE, GLOB_PHI));
-        lineRGBA(renderer,
-                 x-WAVE_STEP, CONFIG_WINDOW_HEIGHT/2+blue_y,
-                 x, CONFIG_WINDOW_HEIGHT/2+blue_ny,
-                 0, 0, 255, 100);
-        blue_y = blue_ny;
-
-        int combined_ny = red_ny + blue_ny;
-        lineRGBA(renderer,
-                 x-WAVE_STEP, CONFIG_WINDOW_HEIGHT/2+combined_y,
-                 x, CONFIG_WINDOW_HEIGHT/2+combined_ny,
-                 0, 255, 0, 255);
-        combined_y = combined_ny;
+    Widget *slider = data;
+
+    slider->slider_value = wave_step_snap(slider->slider_value, DEFAULT_GLOB_PERIOD);
+    callback_slider_setvar_double(data);
+}
+
+/* The step within the period, false when steps do not repeat the phase exactly. */
+static bool wave_clock_bin(const WaveClock *clock, double period, int *bin)
+{
+    if (clock->dt == 0) {
+        *bin = 0;
+        return true;
     }
+
+    double steps = round(period / clock->dt);
+    if (steps < 1 || steps > WAVE_CACHE_MAX_BINS || fabs(steps * clock->dt - period) > 1e-12 * period)
+        return false;
+
+    *bin = (int)(clock->steps % (long long)steps);
+    return true;
 }
 
-typedef struct DopplerPoint {
-    int x, r, a;
-    bool hit;
-} DopplerPoint;
+// cached frames hold their curves back to back as n, x[n], y[n]
+static size_t curves_size(WaveCurve **curves, int count)
+{
+    size_t size = 0;
+    for (int c = 0; c < count; c++)
+        size += sizeof(int) + 2 * sizeof(float) * curves[c]->n;
+    return size;
+}
+
+static void curves_store(FrameCache *fc, uint64_t key, WaveCurve **curves, int count)
+{
+    unsigned char *p = framecache_put(fc, key, curves_size(curves, count));
+    if (!p)
+        return;
+
+    for (int c = 0; c < count; c++) {
+        int n = curves[c]->n;
+        memcpy(p, &n, sizeof(int));
+        p += sizeof(int);
+        memcpy(p, curves[c]->x, sizeof(float) * n);
+        p += sizeof(float) * n;
+        memcpy(p, curves[c]->y, sizeof(float) * n);
+        p += sizeof(float) * n;
+    }
+}
 
-void draw_scene_doppler()
+static bool curves_load(FrameCache *fc, uint64_t key, WaveCurve **curves, int count)
 {
-#define DOPPLER_LAMBDA 45
-#define DP_BUFFER_SIZE 16
-
-#define DP_SRC_Y (CONFIG_WINDOW_HEIGHT/2)
-
-#define DP_LISTENER_X (CONFIG_WINDOW_WIDTH/2)
-#define DP_LISTENER_Y (CONFIG_WINDOW_HEIGHT/2)
-
-#define DP_GRAPH_SIZE 50
-
-    static DopplerPoint buffer[DP_BUFFER_SIZE];
-    static int buffer_idx = 0;
-    static int sound_src_pos = 0;
-    static int graph[DP_GRAPH_SIZE] = {0};
-    static int graph_idx;
-    static int prev_hit_t = -1;
-    static int t = 0;
-    t = (t + 1) % INT_MAX;
-
-    sound_src_pos = (sound_src_pos + DOPPLER_V) % CONFIG_WINDOW_WIDTH;
-    filledCircleRGBA(renderer, sound_src_pos, DP_SRC_Y, 20, 255, 0, 0, 255); // source
-
-    if (t % (DOPPLER_LAMBDA) == 0) {
-        buffer[buffer_idx].x = sound_src_pos;
-        buffer[buffer_idx].r = 1;
-        buffer[buffer_idx].a = 255;
-        buffer[buffer_idx].hit = false;
-        buffer_idx = (buffer_idx + 1) % (DP_BUFFER_SIZE);
+    const unsigned char *p = framecache_get(fc, key, NULL);
+    if (!p)
+        return false;
+
+    for (int c = 0; c < count; c++) {
+        int n;
+        memcpy(&n, p, sizeof(int));
+        p += sizeof(int);
+        curves[c]->n = n;
+        memcpy(curves[c]->x, p, sizeof(float) * n);
+        p += sizeof(float) * n;
+        memcpy(curves[c]->y, p, sizeof(float) * n);
+        p += sizeof(float) * n;
     }
 
-    for (int i = 0; i < DP_BUFFER_SIZE; i++) {
-        if (buffer[i].a != 0 && t % 5 == 0) {
-            buffer[i].a -= 5;
-        }
+    return true;
+}
 
-        int x_dist = abs(DP_LISTENER_X - buffer[i].x);
-        int y_dist = abs(DP_LISTENER_Y - DP_SRC_Y);
-        int p = sqrt(x_dist*x_dist + y_dist*y_dist);
-        if (!buffer[i].hit && abs(p - buffer[i].r) < DOPPLER_WAVE_SPEED) {
-            buffer[i].hit = true;
+static uint64_t wave_cache_key(FrameCache *fc, const double *params, size_t size, int bin)
+{
+    uint64_t h = framecache_hash(FRAMECACHE_HASH_INIT, params, size);
+    framecache_validate(fc, h);
+    return framecache_hash(h, &bin, sizeof(bin));
+}
 
-            if (prev_hit_t > 0) {
-                graph[graph_idx] = (int)(1/(double)(t - prev_hit_t) * 400) - 16;
+typedef struct BasicSnap {
+    WaveCurve wave;
+} BasicSnap;
 
-                graph_idx = (graph_idx + 1) % DP_GRAPH_SIZE;
-            }
+static WavePhasor basic_wave;
+static WaveClock basic_clock;
+static FrameCache basic_cache;
 
-            prev_hit_t = t;
-        }
+// also called by the snapshot, which may come before the first step
+static void basic_wave_set()
+{
+    wave_phasor_set(&basic_wave, TIME_STEP, 1.0/SCALE, GLOB_PERIOD, GLOB_LAMBDA, GLOB_AMPLITUDE, 0.f);
+}
+
+void sim_scene_basic()
+{
+    basic_wave_set();
+    wave_phasor_step(&basic_wave);
+    wave_clock_step(&basic_clock, &basic_wave, TIME_STEP);
+}
 
-#define DP_GR_X1 (CONFIG_WINDOW_WIDTH-400)
-#define DP_GR_Y1 (CONFIG_WINDOW_HEIGHT-350)
-#define DP_GR_WIDTH 300
-#define DP_GR_HEIGHT 300
-#define DP_GR_STEP (DP_GR_WIDTH/DP_GRAPH_SIZE)
+void snap_scene_basic(void *snap)
+{
+    BasicSnap *bs = snap;
+    WaveCurve *curves[] = { &bs->wave };
 
+    if (!basic_cache.budget)
+        framecache_init(&basic_cache, CONFIG_FRAMECACHE_BYTES);
 
-        render_text("f [hz]", DP_GR_X1 - 75, DP_GR_Y1, font_small);
-        render_text("t [s]", DP_GR_X1, DP_GR_Y1 + DP_GR_HEIGHT, font_small);
+    double tolerance = GLOB_TOLERANCE * BASIC_GOV_TOLERANCE;
+    const double params[] = {
+        TIME_STEP, basic_clock.t_base, GLOB_PERIOD, GLOB_LAMBDA, GLOB_AMPLITUDE, tolerance
+    };
+    int bin;
+    bool cached = wave_clock_bin(&basic_clock, GLOB_PERIOD, &bin);
+    uint64_t key = cached ? wave_cache_key(&basic_cache, params, sizeof(params), bin) : 0;
 
-        lineColor(renderer, DP_GR_X1, DP_GR_Y1, DP_GR_X1, DP_GR_Y1+DP_GR_HEIGHT, 0xFFFFFFFF);
-        lineColor(renderer, DP_GR_X1, DP_GR_Y1+DP_GR_HEIGHT, DP_GR_X1+DP_GR_WIDTH, DP_GR_Y1+DP_GR_HEIGHT, 0xFFFFFFFF);
-             
-        for (int g = 0; g < graph_idx-1; g++) {
-            lineRGBA(renderer,
-                     DP_GR_X1 + DP_GR_STEP*g, DP_GR_Y1 + DP_GR_HEIGHT/2 - 5*graph[g],
-                     DP_GR_X1 + DP_GR_STEP*(g+1), DP_GR_Y1 + DP_GR_HEIGHT/2 - 5*graph[g+1],
-                     255, 0, 0, 255);
-        }
+    if (cached && curves_load(&basic_cache, key, curves, 1))
+        return;
 
-        if (buffer[i].a > 0) {
-            aacircleRGBA(renderer, buffer[i].x, DP_SRC_Y, buffer[i].r,
-                         255, 255, 255, buffer[i].a);
+    basic_wave_set();
+    wave_phasor_sample(&basic_wave, dense, WAVE_SAMPLES, (double)START_POS/SCALE);
+    curve_build(&bs->wave, dense, tolerance);
 
-            buffer[i].r += DOPPLER_WAVE_SPEED;
-        }
+    if (cached)
+        curves_store(&basic_cache, key, curves, 1);
+}
+
+void draw_scene_basic(const void *snap)
+{
+    const BasicSnap *bs = snap;
+
+    // animate basic wave equation
+    curve_draw(&bs->wave, 255, 0, 0, 255);
+
+    char buff[32];
+    snprintf(buff, sizeof(buff), "%d / %d vertices", bs->wave.n, WAVE_SAMPLES);
+    render_text(buff, 20, CONFIG_WINDOW_HEIGHT - 40, font_small);
+}
+
+typedef struct InterferenceSnap {
+    WaveCurve red, blue, sum;
+} InterferenceSnap;
+
+static WavePhasor interf_red, interf_blue;
+static WaveClock interf_clock;
+static FrameCache interf_cache;
+static float dense_blue[WAVE_SAMPLES];
+
+// tone of each wave, a listener hears their sum, one sine of amplitude 2A|cos(phi/2)|
+#define INTERF_AUDIO_HZ 220
+#define INTERF_AUDIO_AMP 0.2
+
+// also called by the snapshot, which may come before the first step
+static void interf_waves_set()
+{
+    wave_phasor_set(&interf_red, TIME_STEP, 1.0/SCALE,
+                    DEFAULT_GLOB_PERIOD, DEFAULT_GLOB_LAMBDA, DEFAULT_GLOB_AMPLITUDE, 0.f);
+    wave_phasor_set(&interf_blue, TIME_STEP, 1.0/SCALE,
+                    DEFAULT_GLOB_PERIOD, DEFAULT_GLOB_LAMBDA, DEFAULT_GLOB_AMPLITUDE, GLOB_PHI);
+}
+
+void sim_scene_interference()
+{
+    interf_waves_set();
+    wave_phasor_step(&interf_red);
+    wave_phasor_step(&interf_blue);
+    wave_clock_step(&interf_clock, &interf_red, TIME_STEP);
+
+    audio_tone(INTERF_AUDIO_HZ, 2 * INTERF_AUDIO_AMP * fabs(cos(GLOB_PHI / 2)));
+}
+
+void snap_scene_interference(void *snap)
+{
+    InterferenceSnap *is = snap;
+    WaveCurve *curves[] = { &is->red, &is->blue, &is->sum };
+
+    if (!interf_cache.budget)
+        framecache_init(&interf_cache, CONFIG_FRAMECACHE_BYTES);
+
+    double tolerance = GLOB_TOLERANCE * INTERF_GOV_TOLERANCE;
+    const double params[] = { TIME_STEP, interf_clock.t_base, GLOB_PHI, tolerance };
+    int bin;
+    bool cached = wave_clock_bin(&interf_clock, DEFAULT_GLOB_PERIOD, &bin);
+    uint64_t key = cached ? wave_cache_key(&interf_cache, params, sizeof(params), bin) : 0;
 
+    if (cached && curves_load(&interf_cache, key, curves, 3))
+        return;
+
+    interf_waves_set();
+    wave_phasor_sample(&interf_red, dense, WAVE_SAMPLES, (double)START_POS/SCALE);
+    wave_phasor_sample(&interf_blue, dense_blue, WAVE_SAMPLES, (double)START_POS/SCALE);
+    curve_build(&is->red, dense, tolerance);
+    curve_build(&is->blue, dense_blue, tolerance);
+
+    for (int i = 0; i < WAVE_SAMPLES; i++)
+        dense[i] += dense_blue[i];
+    curve_build(&is->sum, dense, tolerance);
+
+    if (cached)
+        curves_store(&interf_cache, key, curves, 3);
+}
+
+#define INTERF_MEASURE_SAMPLES 256
+
+/*
+ * Peak and RMS of the sum of the two waves over one wavelength, the sweep's
+ * stand-in for the interference scene. Reentrant, uses the kernels picked by
+ * wave_init() at startup.
+ */
+void interference_measure(double phi, double lambda, double amplitude,
+                          double *peak, double *rms)
+{
+    float a[INTERF_MEASURE_SAMPLES], b[INTERF_MEASURE_SAMPLES];
+    double dx = lambda / INTERF_MEASURE_SAMPLES;
+
+    wave_func_batch(a, INTERF_MEASURE_SAMPLES, 0, 0, dx, DEFAULT_GLOB_PERIOD, lambda, amplitude, 0);
+    wave_func_batch(b, INTERF_MEASURE_SAMPLES, 0, 0, dx, DEFAULT_GLOB_PERIOD, lambda, amplitude, phi);
+
+    double max = 0, sq = 0;
+    for (int i = 0; i < INTERF_MEASURE_SAMPLES; i++) {
+        double y = (double)a[i] + b[i];
+        max = fmax(max, fabs(y));
+        sq += y * y;
     }
 
-    filledCircleRGBA(renderer, DP_LISTENER_X, DP_LISTENER_Y, 20, 0, 255, 0, 255); // listener
+    *peak = max;
+    *rms = sqrt(sq / INTERF_MEASURE_SAMPLES);
+}
+
+void draw_scene_interference(const void *snap)
+{
+    const InterferenceSnap *is = snap;
+
+    curve_draw(&is->red, 255, 0, 0, 100);
+    curve_draw(&is->blue, 0, 0, 255, 100);
+    curve_draw(&is->sum, 0, 255, 0, 255);
+}
+
+#define WAVE_GOV_LEVELS 4
+
+static void knob_basic_samples(int level)
+{
+    sim_param_set_double(&BASIC_GOV_TOLERANCE, 1 << level);
+}
+
+static void knob_interf_samples(int level)
+{
+    sim_param_set_double(&INTERF_GOV_TOLERANCE, 1 << level);
 }
 
 // this is horrible and ugly but idk how to ensure consistent indexes for passing ptrs to .data (enum??)
 #define BASIC_LAMBDA_SLIDER 0
 #define BASIC_AMPLITUDE_SLIDER 1
 #define BASIC_TIME_SLIDER 2
-#define BASIC_POINT_SLIDER 3
+#define BASIC_TOLERANCE_SLIDER 3
 
 #define INTERF_OFFSET 0
 #define INTERF_TIME_SLIDER 1
 
 #define DOPPLER_V_SLIDER 0
 #define DOPPLER_WAVE_SPEED_SLIDER 1
+#define DOPPLER_SOURCES_SLIDER 2
+
+#define FIELD_LAMBDA_SLIDER 0
+#define FIELD_RES_SLIDER 1
+
+#define STRING_SPEED_SLIDER 0
+#define STRING_DAMPING_SLIDER 1
+
+#define MEMBRANE_SPEED_SLIDER 0
+#define MEMBRANE_DAMPING_SLIDER 1
+
+#define MEDIUM_LAMBDA_SLIDER 0
+#define MEDIUM_AMPLITUDE_SLIDER 1
 
 Scene SCENES[] = {
     [SCENE_MENU] = {
+        .name = "menu",
+        .simfn = sim_scene_menu,
+        .snapfn = snap_scene_menu,
+        .snap_size = sizeof(MenuSnap),
         .drawfn = draw_scene_menu,
+        .staticfn = draw_static_menu,
         .widgets = {
             {
                 .widget_type = WIDGET_BUTTON,
-                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 350,
-                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 440,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 215,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 285,
                 .label = "wave fn.",
                 .callback = callback_switch_scene,
                 .callback_data = &SCENES[SCENE_BASIC_WAVE_FUNC],
             },
             {
                 .widget_type = WIDGET_BUTTON,
-                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 460,
-                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 540,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 300,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 370,
                 .label = "interference",
                 .callback = callback_switch_scene,
                 .callback_data = &SCENES[SCENE_INTERFERENCE],
             },
             {
                 .widget_type = WIDGET_BUTTON,
-                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 560,
-                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 640,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 385,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 455,
                 .label = "doppler",
                 .callback = callback_switch_scene,
                 .callback_data = &SCENES[SCENE_DOPPLER],
             },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 470,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 540,
+                .label = "field",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_FIELD],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 555,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 625,
+                .label = "string",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_STRING],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 640,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 710,
+                .label = "membrane",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_MEMBRANE],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 725,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 795,
+                .label = "fourier",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_FOURIER],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = CONFIG_WINDOW_WIDTH/2 - 150, .y1 = 810,
+                .x2 = CONFIG_WINDOW_WIDTH/2 + 150, .y2 = 880,
+                .label = "medium",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_MEDIUM],
+            },
             {
                 .widget_type = WIDGET_END
             }
         }
     },
     [SCENE_DOPPLER] = {
-        .drawfn =  draw_scene_doppler,
+        .name = "doppler",
+        .simfn = sim_scene_doppler,
+        .snapfn = snap_scene_doppler,
+        .snap_size = sizeof(DopplerSnap),
+        .drawfn = draw_scene_doppler,
+        .staticfn = draw_static_doppler,
+        .knobs = {
+            { .name = "fronts", .levels = DOPPLER_GOV_LEVELS, .apply = knob_doppler_fronts },
+        },
         .widgets = {
             [DOPPLER_V_SLIDER] = {
                 .widget_type = WIDGET_SLIDER,
@@ -316,6 +541,23 @@ Scene SCENES[] = {
                 .callback = callback_slider_setvar_int,
                 .callback_data = &SCENES[SCENE_DOPPLER].widgets[DOPPLER_WAVE_SPEED_SLIDER]
             },
+            [DOPPLER_SOURCES_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 500, .y1 = 10,
+                .x2 = 700, .y2 = 150,
+                .label = "sources",
+                .slider_min = 1, .slider_max = DOPPLER_MAX_SOURCES,
+                .slider_value = DEFAULT_DOPPLER_SOURCES, .slider_var = &DOPPLER_SOURCES,
+                .callback = callback_slider_setvar_int,
+                .callback_data = &SCENES[SCENE_DOPPLER].widgets[DOPPLER_SOURCES_SLIDER]
+            },
+            {
+                .widget_type = WIDGET_PLOT,
+                .x1 = DP_PLOT_X1, .y1 = DP_PLOT_Y1,
+                .x2 = DP_PLOT_X2, .y2 = DP_PLOT_Y2,
+                .label = "f [Hz]",
+                .plot = &DOPPLER_PLOT,
+            },
             {
                 .widget_type = WIDGET_BUTTON,
                 .x1 = 0, .y1 = 0,
@@ -329,8 +571,333 @@ Scene SCENES[] = {
             }
         }
     },
+    [SCENE_FIELD] = {
+        .name = "field",
+        .simfn = sim_scene_field,
+        .snapfn = snap_scene_field,
+        .snap_size = sizeof(FieldSnap),
+        .drawfn = draw_scene_field,
+        .knobs = {
+            { .name = "resolution", .levels = FIELD_MAX_RES_DIV, .apply = knob_field_res },
+        },
+        .widgets = {
+            [FIELD_LAMBDA_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 1100, .y1 = 10,
+                .x2 = 1300, .y2 = 150,
+                .label = "lambda",
+                .slider_min = 5, .slider_max = 200,
+                .slider_value = DEFAULT_FIELD_LAMBDA, .slider_var = &FIELD_LAMBDA,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_FIELD].widgets[FIELD_LAMBDA_SLIDER]
+            },
+            [FIELD_RES_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 800, .y1 = 10,
+                .x2 = 1000, .y2 = 150,
+                .label = "pixel size",
+                .slider_min = 1, .slider_max = FIELD_MAX_RES_DIV,
+                .slider_value = DEFAULT_FIELD_RES_DIV, .slider_var = &FIELD_RES_DIV,
+                .callback = callback_slider_setvar_int,
+                .callback_data = &SCENES[SCENE_FIELD].widgets[FIELD_RES_SLIDER]
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 0,
+                .x2 = 300, .y2 = 80,
+                .label = "Back to Menu",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_MENU],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 100,
+                .x2 = 300, .y2 = 180,
+                .label = "add source",
+                .callback = callback_field_add_source,
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 200,
+                .x2 = 300, .y2 = 280,
+                .label = "clear",
+                .callback = callback_field_clear_sources,
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 300,
+                .x2 = 300, .y2 = 380,
+                .label = "mode",
+                .callback = callback_field_toggle_mode,
+            },
+            {
+                .widget_type = WIDGET_END
+            }
+        }
+    },
+    [SCENE_STRING] = {
+        .name = "string",
+        .simfn = sim_scene_string,
+        .snapfn = snap_scene_string,
+        .snap_size = sizeof(StringSnap),
+        .drawfn = draw_scene_string,
+        .staticfn = draw_static_string,
+        .widgets = {
+            [STRING_SPEED_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 1100, .y1 = 10,
+                .x2 = 1300, .y2 = 150,
+                .label = "courant",
+                .slider_min = 0.05, .slider_max = 1,
+                .slider_value = DEFAULT_FD_COURANT, .slider_var = &STRING_COURANT,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_STRING].widgets[STRING_SPEED_SLIDER]
+            },
+            [STRING_DAMPING_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 800, .y1 = 10,
+                .x2 = 1000, .y2 = 150,
+                .label = "damping",
+                .slider_min = 0, .slider_max = 0.02,
+                .slider_value = DEFAULT_FD_DAMPING, .slider_var = &STRING_DAMPING,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_STRING].widgets[STRING_DAMPING_SLIDER]
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 0,
+                .x2 = 300, .y2 = 80,
+                .label = "Back to Menu",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_MENU],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 100,
+                .x2 = 300, .y2 = 180,
+                .label = "pluck",
+                .callback = callback_string_pluck,
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 200,
+                .x2 = 300, .y2 = 280,
+                .label = "boundary",
+                .callback = callback_string_boundary,
+            },
+            {
+                .widget_type = WIDGET_END
+            }
+        }
+    },
+    [SCENE_MEMBRANE] = {
+        .name = "membrane",
+        .simfn = sim_scene_membrane,
+        .snapfn = snap_scene_membrane,
+        .snap_size = sizeof(MembraneSnap),
+        .drawfn = draw_scene_membrane,
+        .widgets = {
+            [MEMBRANE_SPEED_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 1100, .y1 = 10,
+                .x2 = 1300, .y2 = 150,
+                .label = "courant",
+                .slider_min = 0.05, .slider_max = 0.7,
+                .slider_value = DEFAULT_FD_COURANT, .slider_var = &MEMBRANE_COURANT,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_MEMBRANE].widgets[MEMBRANE_SPEED_SLIDER]
+            },
+            [MEMBRANE_DAMPING_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 800, .y1 = 10,
+                .x2 = 1000, .y2 = 150,
+                .label = "damping",
+                .slider_min = 0, .slider_max = 0.02,
+                .slider_value = DEFAULT_FD_DAMPING, .slider_var = &MEMBRANE_DAMPING,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_MEMBRANE].widgets[MEMBRANE_DAMPING_SLIDER]
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 0,
+                .x2 = 300, .y2 = 80,
+                .label = "Back to Menu",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_MENU],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 100,
+                .x2 = 300, .y2 = 180,
+                .label = "drop",
+                .callback = callback_membrane_drop,
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 200,
+                .x2 = 300, .y2 = 280,
+                .label = "boundary",
+                .callback = callback_membrane_boundary,
+            },
+            {
+                .widget_type = WIDGET_END
+            }
+        }
+    },
+    [SCENE_FOURIER] = {
+        .name = "fourier",
+        .simfn = sim_scene_fourier,
+        .snapfn = snap_scene_fourier,
+        .snap_size = sizeof(FourierSnap),
+        .drawfn = draw_scene_fourier,
+        .knobs = {
+            { .name = "samples", .levels = FOURIER_GOV_LEVELS, .apply = knob_fourier_samples },
+        },
+        .widgets = {
+            [FOURIER_HARMONICS_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 350, .y1 = 10,
+                .x2 = 550, .y2 = 150,
+                .label = "harmonics",
+                .slider_min = 1, .slider_max = FOURIER_MAX_HARMONICS,
+                .slider_value = DEFAULT_FOURIER_HARMONICS, .slider_var = &FOURIER_HARMONICS,
+                .callback = callback_slider_setvar_int,
+                .callback_data = &SCENES[SCENE_FOURIER].widgets[FOURIER_HARMONICS_SLIDER]
+            },
+            [FOURIER_SELECT_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 620, .y1 = 10,
+                .x2 = 820, .y2 = 150,
+                .label = "edit harmonic",
+                .slider_min = 1, .slider_max = FOURIER_BARS,
+                .slider_value = 1, .slider_var = NULL,
+                .callback = callback_fourier_select,
+                .callback_data = &SCENES[SCENE_FOURIER].widgets[FOURIER_SELECT_SLIDER]
+            },
+            [FOURIER_AMP_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 890, .y1 = 10,
+                .x2 = 1090, .y2 = 150,
+                .label = "amplitude",
+                .slider_min = 0, .slider_max = 1.5,
+                .slider_value = 4/PI, .slider_var = NULL,
+                .callback = callback_fourier_amp,
+                .callback_data = &SCENES[SCENE_FOURIER].widgets[FOURIER_AMP_SLIDER]
+            },
+            [FOURIER_PHASE_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 1160, .y1 = 10,
+                .x2 = 1360, .y2 = 150,
+                .label = "phase",
+                .slider_min = 0, .slider_max = 2*PI,
+                .slider_value = 0, .slider_var = NULL,
+                .callback = callback_fourier_phase,
+                .callback_data = &SCENES[SCENE_FOURIER].widgets[FOURIER_PHASE_SLIDER]
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 0,
+                .x2 = 300, .y2 = 80,
+                .label = "Back to Menu",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_MENU],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 100,
+                .x2 = 300, .y2 = 180,
+                .label = "sine",
+                .callback = callback_fourier_preset,
+                .callback_data = (void *)FOURIER_SINE,
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 200,
+                .x2 = 300, .y2 = 280,
+                .label = "square",
+                .callback = callback_fourier_preset,
+                .callback_data = (void *)FOURIER_SQUARE,
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 300,
+                .x2 = 300, .y2 = 380,
+                .label = "sawtooth",
+                .callback = callback_fourier_preset,
+                .callback_data = (void *)FOURIER_SAWTOOTH,
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 400,
+                .x2 = 300, .y2 = 480,
+                .label = "triangle",
+                .callback = callback_fourier_preset,
+                .callback_data = (void *)FOURIER_TRIANGLE,
+            },
+            {
+                .widget_type = WIDGET_END
+            }
+        }
+    },
+    [SCENE_MEDIUM] = {
+        .name = "medium",
+        .simfn = sim_scene_medium,
+        .snapfn = snap_scene_medium,
+        .snap_size = sizeof(MediumSnap),
+        .drawfn = draw_scene_medium,
+        .knobs = {
+            { .name = "particles", .levels = MEDIUM_GOV_LEVELS, .apply = knob_medium_particles },
+        },
+        .widgets = {
+            [MEDIUM_LAMBDA_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 800, .y1 = 10,
+                .x2 = 1000, .y2 = 150,
+                .label = "lambda",
+                .slider_min = 50, .slider_max = 600,
+                .slider_value = DEFAULT_MEDIUM_LAMBDA, .slider_var = &MEDIUM_LAMBDA,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_MEDIUM].widgets[MEDIUM_LAMBDA_SLIDER]
+            },
+            [MEDIUM_AMPLITUDE_SLIDER] = {
+                .widget_type = WIDGET_SLIDER,
+                .x1 = 1100, .y1 = 10,
+                .x2 = 1300, .y2 = 150,
+                .label = "amplitude",
+                .slider_min = 0, .slider_max = 30,
+                .slider_value = DEFAULT_MEDIUM_AMPLITUDE, .slider_var = &MEDIUM_AMPLITUDE,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_MEDIUM].widgets[MEDIUM_AMPLITUDE_SLIDER]
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 0,
+                .x2 = 300, .y2 = 80,
+                .label = "Back to Menu",
+                .callback = callback_switch_scene,
+                .callback_data = &SCENES[SCENE_MENU],
+            },
+            {
+                .widget_type = WIDGET_BUTTON,
+                .x1 = 0, .y1 = 100,
+                .x2 = 300, .y2 = 180,
+                .label = "mode",
+                .callback = callback_medium_toggle_mode,
+            },
+            {
+                .widget_type = WIDGET_END
+            }
+        }
+    },
     [SCENE_INTERFERENCE] = {
+        .name = "interference",
+        .simfn = sim_scene_interference,
+        .snapfn = snap_scene_interference,
+        .snap_size = sizeof(InterferenceSnap),
         .drawfn = draw_scene_interference,
+        .knobs = {
+            { .name = "samples", .levels = WAVE_GOV_LEVELS, .apply = knob_interf_samples },
+        },
         .widgets = {
             [INTERF_OFFSET] = {
                 .widget_type = WIDGET_SLIDER,
@@ -349,7 +916,7 @@ Scene SCENES[] = {
                 .label = "time flow",
                 .slider_min = 0, .slider_max = 1,
                 .slider_value = DEFAULT_TIME_STEP, .slider_var = &TIME_STEP,
-                .callback = callback_slider_setvar_double,
+                .callback = callback_time_step,
                 .callback_data = &SCENES[SCENE_INTERFERENCE].widgets[INTERF_TIME_SLIDER] 
             },
             {
@@ -366,7 +933,14 @@ Scene SCENES[] = {
         }
     },
     [SCENE_BASIC_WAVE_FUNC] = {
+        .name = "wave_fn",
+        .simfn = sim_scene_basic,
+        .snapfn = snap_scene_basic,
+        .snap_size = sizeof(BasicSnap),
         .drawfn = draw_scene_basic,
+        .knobs = {
+            { .name = "samples", .levels = WAVE_GOV_LEVELS, .apply = knob_basic_samples },
+        },
         .widgets = {
             [BASIC_LAMBDA_SLIDER] = {
                 .widget_type = WIDGET_SLIDER,
@@ -395,18 +969,18 @@ Scene SCENES[] = {
                 .label = "time flow",
                 .slider_min = 0, .slider_max = 1,
                 .slider_value = DEFAULT_TIME_STEP, .slider_var = &TIME_STEP,
-                .callback = callback_slider_setvar_double,
+                .callback = callback_time_step,
                 .callback_data = &SCENES[SCENE_BASIC_WAVE_FUNC].widgets[BASIC_TIME_SLIDER] 
             },
-            [BASIC_POINT_SLIDER] = {
+            [BASIC_TOLERANCE_SLIDER] = {
                 .widget_type = WIDGET_SLIDER,
                 .x1 = 1100, .y1 = CONFIG_WINDOW_HEIGHT-150,
                 .x2 = 1300, .y2 = CONFIG_WINDOW_HEIGHT-40,
-                .label = "wave points",
-                .slider_min = 10, .slider_max = CONFIG_WINDOW_WIDTH,
-                .slider_value = DEFAULT_GLOB_WAVE_POINTS, .slider_var = &GLOB_WAVE_POINTS,
-                .callback = callback_slider_setvar_int,
-                .callback_data = &SCENES[SCENE_BASIC_WAVE_FUNC].widgets[BASIC_POINT_SLIDER] 
+                .label = "tolerance [px]",
+                .slider_min = 0.05, .slider_max = 2,
+                .slider_value = DEFAULT_GLOB_TOLERANCE, .slider_var = &GLOB_TOLERANCE,
+                .callback = callback_slider_setvar_double,
+                .callback_data = &SCENES[SCENE_BASIC_WAVE_FUNC].widgets[BASIC_TOLERANCE_SLIDER]
             },
             {
                 .widget_type = WIDGET_BUTTON,
@@ -423,13 +997,19 @@ Scene SCENES[] = {
     }
 };
 
-void draw_scene(Scene *scene)
+void draw_scene_content(Scene *scene)
 {
-    // draw main contents of the scene
+    dl_layer(DL_LAYER_SCENE);
+
+    PROF_BEGIN(PROF_DRAWFN);
     if (scene->drawfn)
-        scene->drawfn();
+        scene->drawfn(sim_snapshot(scene));
+    PROF_END(PROF_DRAWFN);
+}
 
-    // draw associated widgets
+void draw_scene_widgets(Scene *scene)
+{
+    dl_layer(DL_LAYER_WIDGETS);
     for (int i = 0; i < CONFIG_MAX_WIDGETS; i++) {
         if (scene->widgets[i].widget_type == WIDGET_END)
             break;
@@ -437,3 +1017,34 @@ void draw_scene(Scene *scene)
         draw_widget(&scene->widgets[i]);
     }
 }
+
+void draw_scene_plots(Scene *scene)
+{
+    dl_layer(DL_LAYER_SCENE);
+    for (int i = 0; i < CONFIG_MAX_WIDGETS; i++) {
+        Widget *widget = &scene->widgets[i];
+        if (widget->widget_type == WIDGET_END)
+            break;
+
+        if (widget->widget_type == WIDGET_PLOT)
+            plot_draw(widget->plot, widget->x1, widget->y1, widget->x2, widget->y2);
+    }
+}
+
+void draw_scene(Scene *scene)
+{
+    PROF_BEGIN(PROF_DRAW_SCENE);
+
+    // cached static layer, animated contents on top of it
+    comp_static(scene);
+    draw_scene_content(scene);
+    comp_flush();
+
+    // plot curves change every frame, only their frames are in the widget layer
+    draw_scene_plots(scene);
+
+    // cached widget layer on top of everything
+    comp_widgets(scene);
+
+    PROF_END(PROF_DRAW_SCENE);
+}
@@ -2,11 +2,20 @@
 #define _DRAW_H
 
 #include "widgets.h"
+#include "governor.h"
 #include "config.h"
 
 typedef struct Scene {
-    void (*drawfn)();
+    const char *name;
+
+    void (*simfn)();
+    void (*snapfn)(void *snap);
+    size_t snap_size;
+    void (*drawfn)(const void *snap);
+    void (*staticfn)(void); // content that never changes, cached by the compositor
+
     Widget widgets[CONFIG_MAX_WIDGETS];
+    GovKnob knobs[CONFIG_GOV_MAX_KNOBS]; // in the order the governor lowers them
 } Scene;
 
 typedef enum SceneEnum {
@@ -14,12 +23,26 @@ typedef enum SceneEnum {
     SCENE_BASIC_WAVE_FUNC,
     SCENE_INTERFERENCE,
     SCENE_DOPPLER,
+    SCENE_FIELD,
+    SCENE_STRING,
+    SCENE_MEMBRANE,
+    SCENE_FOURIER,
+    SCENE_MEDIUM,
     SCENE_END
 } SceneEnum;
 
+#define DEFAULT_GLOB_AMPLITUDE 2.f
+#define DEFAULT_GLOB_LAMBDA 30.f
+#define DEFAULT_GLOB_PHI 0.f
+
 extern Scene SCENES[];
 
 void draw_scene(Scene *scene);
-void render_text(const char *text, int x1, int y1, TTF_Font *font);
+void draw_scene_content(Scene *scene);
+void draw_scene_widgets(Scene *scene);
+void draw_scene_plots(Scene *scene);
+
+void interference_measure(double phi, double lambda, double amplitude,
+                          double *peak, double *rms);
 
 #endif /* _DRAW_H */
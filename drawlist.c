@@ -0,0 +1,523 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#include "drawlist.h"
+#include "utils.h"
+#include "prof.h"
+#include "softrast.h"
+
+extern SDL_Renderer *renderer;
+
+#define DL_PI 3.14159265358979f
+
+typedef enum DrawCmdType {
+    DC_LINES,
+    DC_BOX,
+    DC_CIRCLE,
+    DC_FILLED_CIRCLE,
+    DC_POINTS,
+} DrawCmdType;
+
+typedef struct DrawCmd {
+    DrawCmdType type;
+    DrawLayer layer;
+    SDL_Color color;
+    float width;
+    int seq;
+
+    union {
+        // DC_LINES and DC_POINTS, range in points[]
+        struct {
+            int first, count;
+        };
+        // DC_BOX, DC_CIRCLE and DC_FILLED_CIRCLE (x1, y1 = center, x2 = radius)
+        struct {
+            float x1, y1, x2, y2;
+        };
+    };
+} DrawCmd;
+
+static DrawCmd *cmds;
+static int ncmds, cmds_cap;
+static int *order;
+static int order_cap;
+
+static SDL_FPoint *points;
+static int npoints, points_cap;
+
+// circle outlines are only tessellated at flush time
+static SDL_FPoint *scratch;
+static int scratch_cap;
+
+static SDL_Vertex *geo_verts;
+static int ngeo_verts, geo_verts_cap;
+static int *geo_indices;
+static int ngeo_indices, geo_indices_cap;
+
+static const char *backend_names[DL_BACKEND_END] = {
+    [DL_BACKEND_SDL] = "sdl",
+    [DL_BACKEND_SOFT] = "soft",
+};
+
+static DrawBackend backend = DL_BACKEND_SDL;
+
+static DrawLayer cur_layer = DL_LAYER_SCENE;
+static float cur_width = 1.f;
+static int open_strip = -1;
+
+static void *grow(void *buf, int *cap, int need, size_t elem)
+{
+    if (need <= *cap)
+        return buf;
+
+    int new_cap = *cap ? *cap : 256;
+    while (new_cap < need)
+        new_cap *= 2;
+
+    buf = realloc(buf, elem * new_cap);
+    if (!buf) {
+        fprintf(stderr, "drawlist: out of memory\n");
+        exit(1);
+    }
+
+    *cap = new_cap;
+    return buf;
+}
+
+static DrawCmd *push_cmd(DrawCmdType type, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    cmds = grow(cmds, &cmds_cap, ncmds + 1, sizeof(*cmds));
+
+    DrawCmd *cmd = &cmds[ncmds];
+    cmd->type = type;
+    cmd->layer = cur_layer;
+    cmd->color = (SDL_Color) {r, g, b, a};
+    cmd->width = cur_width;
+    cmd->seq = ncmds++;
+
+    return cmd;
+}
+
+static void push_point(float x, float y)
+{
+    points = grow(points, &points_cap, npoints + 1, sizeof(*points));
+    points[npoints++] = (SDL_FPoint) {x, y};
+}
+
+bool dl_backend_parse(const char *name, DrawBackend *out)
+{
+    for (int i = 0; i < DL_BACKEND_END; i++) {
+        if (!strcmp(name, backend_names[i])) {
+            *out = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char *dl_backend_name(DrawBackend b)
+{
+    return backend_names[b];
+}
+
+void dl_set_backend(DrawBackend b)
+{
+    backend = b;
+}
+
+DrawBackend dl_backend(void)
+{
+    return backend;
+}
+
+void dl_layer(DrawLayer layer)
+{
+    cur_layer = layer;
+}
+
+void dl_line_width(float width)
+{
+    cur_width = width;
+}
+
+void dl_polyline_begin(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    DrawCmd *cmd = push_cmd(DC_LINES, r, g, b, a);
+    cmd->first = npoints;
+    cmd->count = 0;
+
+    open_strip = cmd->seq;
+}
+
+void dl_vertex(float x, float y)
+{
+    push_point(x, y);
+}
+
+void dl_polyline_end(void)
+{
+    // cmds may have been reallocated, look the strip up by index
+    DrawCmd *cmd = &cmds[open_strip];
+    cmd->count = npoints - cmd->first;
+
+    if (cmd->count < 2 && open_strip == ncmds-1) {
+        npoints = cmd->first;
+        ncmds--;
+    }
+
+    open_strip = -1;
+}
+
+void dl_line(float x1, float y1, float x2, float y2,
+             Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    dl_polyline_begin(r, g, b, a);
+    dl_vertex(x1, y1);
+    dl_vertex(x2, y2);
+    dl_polyline_end();
+}
+
+void dl_rect(float x1, float y1, float x2, float y2,
+             Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    dl_polyline_begin(r, g, b, a);
+    dl_vertex(x1, y1);
+    dl_vertex(x2, y1);
+    dl_vertex(x2, y2);
+    dl_vertex(x1, y2);
+    dl_vertex(x1, y1);
+    dl_polyline_end();
+}
+
+void dl_box(float x1, float y1, float x2, float y2,
+            Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    DrawCmd *cmd = push_cmd(DC_BOX, r, g, b, a);
+    cmd->x1 = x1; cmd->y1 = y1;
+    cmd->x2 = x2; cmd->y2 = y2;
+}
+
+static int circle_segments(float rad)
+{
+    return clamp_int((int)(2*DL_PI*rad/10), 16, 256);
+}
+
+/* Writes the n+1 points of a closed circle outline into out. */
+static void circle_points(SDL_FPoint *out, int n, float x, float y, float rad)
+{
+    float c = cosf(2*DL_PI/n), s = sinf(2*DL_PI/n);
+    float dx = rad, dy = 0;
+
+    for (int i = 0; i < n; i++) {
+        out[i] = (SDL_FPoint) {x + dx, y + dy};
+
+        float ndx = dx*c - dy*s;
+        dy = dx*s + dy*c;
+        dx = ndx;
+    }
+    out[n] = out[0];
+}
+
+void dl_circle(float x, float y, float rad,
+               Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    DrawCmd *cmd = push_cmd(DC_CIRCLE, r, g, b, a);
+    cmd->x1 = x; cmd->y1 = y;
+    cmd->x2 = rad;
+}
+
+void dl_filled_circle(float x, float y, float rad,
+                      Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    DrawCmd *cmd = push_cmd(DC_FILLED_CIRCLE, r, g, b, a);
+    cmd->x1 = x; cmd->y1 = y;
+    cmd->x2 = rad;
+}
+
+void dl_points(const float *x, const float *y, int n,
+               Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    if (n <= 0)
+        return;
+
+    DrawCmd *cmd = push_cmd(DC_POINTS, r, g, b, a);
+    cmd->first = npoints;
+    cmd->count = n;
+
+    points = grow(points, &points_cap, npoints + n, sizeof(*points));
+    SDL_FPoint *out = &points[npoints];
+    for (int i = 0; i < n; i++)
+        out[i] = (SDL_FPoint) {x[i], y[i]};
+    npoints += n;
+}
+
+// opaque hairlines and points go through SDL_RenderDrawLinesF/PointsF, the rest is triangulated
+static int cmd_is_hairline(const DrawCmd *cmd)
+{
+    return (cmd->type == DC_LINES || cmd->type == DC_CIRCLE || cmd->type == DC_POINTS) &&
+        cmd->color.a == 255 && cmd->width <= 1.f;
+}
+
+static Uint32 color_key(SDL_Color c)
+{
+    return (Uint32)c.r << 24 | (Uint32)c.g << 16 | (Uint32)c.b << 8 | c.a;
+}
+
+static int cmd_compare(const void *a, const void *b)
+{
+    const DrawCmd *ca = &cmds[*(const int *)a];
+    const DrawCmd *cb = &cmds[*(const int *)b];
+
+    if (ca->layer != cb->layer)
+        return ca->layer < cb->layer ? -1 : 1;
+
+    int ha = cmd_is_hairline(ca), hb = cmd_is_hairline(cb);
+    if (ha != hb)
+        return ha - hb;
+
+    if (ha) {
+        Uint32 ka = color_key(ca->color), kb = color_key(cb->color);
+        if (ka != kb)
+            return ka < kb ? -1 : 1;
+    }
+
+    return ca->seq - cb->seq;
+}
+
+static int geo_vertex(float x, float y, SDL_Color color)
+{
+    geo_verts = grow(geo_verts, &geo_verts_cap, ngeo_verts + 1, sizeof(*geo_verts));
+    geo_verts[ngeo_verts] = (SDL_Vertex) { {x, y}, color, {0, 0} };
+
+    return ngeo_verts++;
+}
+
+static void geo_triangle(int a, int b, int c)
+{
+    geo_indices = grow(geo_indices, &geo_indices_cap, ngeo_indices + 3, sizeof(*geo_indices));
+    geo_indices[ngeo_indices++] = a;
+    geo_indices[ngeo_indices++] = b;
+    geo_indices[ngeo_indices++] = c;
+}
+
+static void geo_quad(float x1, float y1, float x2, float y2,
+                     float x3, float y3, float x4, float y4, SDL_Color color)
+{
+    int a = geo_vertex(x1, y1, color);
+    int b = geo_vertex(x2, y2, color);
+    int c = geo_vertex(x3, y3, color);
+    int d = geo_vertex(x4, y4, color);
+
+    geo_triangle(a, b, c);
+    geo_triangle(a, c, d);
+}
+
+/* One width x width square per point, centered on the pixel the point falls in. */
+static void geo_points(const DrawCmd *cmd)
+{
+    int n = cmd->count;
+    geo_verts = grow(geo_verts, &geo_verts_cap, ngeo_verts + 4*n, sizeof(*geo_verts));
+    geo_indices = grow(geo_indices, &geo_indices_cap, ngeo_indices + 6*n, sizeof(*geo_indices));
+
+    float lo = 0.5f - cmd->width/2, hi = 0.5f + cmd->width/2;
+    SDL_Vertex *v = &geo_verts[ngeo_verts];
+    int *idx = &geo_indices[ngeo_indices];
+
+    for (int i = 0; i < n; i++) {
+        SDL_FPoint p = points[cmd->first + i];
+        int a = ngeo_verts + 4*i;
+
+        v[4*i + 0] = (SDL_Vertex) { {p.x + lo, p.y + lo}, cmd->color, {0, 0} };
+        v[4*i + 1] = (SDL_Vertex) { {p.x + hi, p.y + lo}, cmd->color, {0, 0} };
+        v[4*i + 2] = (SDL_Vertex) { {p.x + hi, p.y + hi}, cmd->color, {0, 0} };
+        v[4*i + 3] = (SDL_Vertex) { {p.x + lo, p.y + hi}, cmd->color, {0, 0} };
+
+        idx[6*i + 0] = a; idx[6*i + 1] = a + 1; idx[6*i + 2] = a + 2;
+        idx[6*i + 3] = a; idx[6*i + 4] = a + 2; idx[6*i + 5] = a + 3;
+    }
+
+    ngeo_verts += 4*n;
+    ngeo_indices += 6*n;
+}
+
+static void geo_append(const DrawCmd *cmd)
+{
+    switch (cmd->type) {
+    case DC_LINES: {
+        float hw = cmd->width / 2;
+        for (int i = cmd->first; i < cmd->first + cmd->count - 1; i++) {
+            SDL_FPoint p = points[i], q = points[i+1];
+
+            float dx = q.x - p.x, dy = q.y - p.y;
+            float len = sqrtf(dx*dx + dy*dy);
+            if (len == 0)
+                continue;
+
+            float nx = -dy / len * hw, ny = dx / len * hw;
+            geo_quad(p.x + nx, p.y + ny, q.x + nx, q.y + ny,
+                     q.x - nx, q.y - ny, p.x - nx, p.y - ny, cmd->color);
+        }
+        break;
+    }
+    case DC_CIRCLE: {
+        // ring of quads sharing their edges, inner and outer vertex per step
+        float hw = cmd->width / 2;
+        int n = circle_segments(cmd->x2);
+        scratch = grow(scratch, &scratch_cap, n + 1, sizeof(*scratch));
+        circle_points(scratch, n, 0, 0, 1);
+
+        float r_in = cmd->x2 - hw, r_out = cmd->x2 + hw;
+        int first = ngeo_verts;
+        for (int i = 0; i < n; i++) {
+            geo_vertex(cmd->x1 + scratch[i].x*r_in, cmd->y1 + scratch[i].y*r_in, cmd->color);
+            geo_vertex(cmd->x1 + scratch[i].x*r_out, cmd->y1 + scratch[i].y*r_out, cmd->color);
+        }
+        for (int i = 0; i < n; i++) {
+            int a = first + 2*i, b = first + 2*((i+1) % n);
+            geo_triangle(a, a+1, b+1);
+            geo_triangle(a, b+1, b);
+        }
+        break;
+    }
+    case DC_BOX:
+        geo_quad(cmd->x1, cmd->y1, cmd->x2 + 1, cmd->y1,
+                 cmd->x2 + 1, cmd->y2 + 1, cmd->x1, cmd->y2 + 1, cmd->color);
+        break;
+    case DC_FILLED_CIRCLE: {
+        int n = circle_segments(cmd->x2);
+        float c = cosf(2*DL_PI/n), s = sinf(2*DL_PI/n);
+        float dx = cmd->x2, dy = 0;
+
+        int center = geo_vertex(cmd->x1, cmd->y1, cmd->color);
+        int first = geo_vertex(cmd->x1 + dx, cmd->y1 + dy, cmd->color);
+        int prev = first;
+        for (int i = 1; i < n; i++) {
+            float ndx = dx*c - dy*s;
+            dy = dx*s + dy*c;
+            dx = ndx;
+
+            int cur = geo_vertex(cmd->x1 + dx, cmd->y1 + dy, cmd->color);
+            geo_triangle(center, prev, cur);
+            prev = cur;
+        }
+        geo_triangle(center, prev, first);
+        break;
+    }
+    case DC_POINTS:
+        geo_points(cmd);
+        break;
+    }
+}
+
+static void geo_submit(void)
+{
+    if (ngeo_indices)
+        SDL_RenderGeometry(renderer, NULL, geo_verts, ngeo_verts, geo_indices, ngeo_indices);
+
+    ngeo_verts = 0;
+    ngeo_indices = 0;
+}
+
+static void soft_submit(void)
+{
+    for (int i = 0; i < ncmds; i++) {
+        DrawCmd *cmd = &cmds[order[i]];
+
+        switch (cmd->type) {
+        case DC_LINES:
+            softrast_polyline(&points[cmd->first], cmd->count, cmd->color);
+            break;
+        case DC_BOX:
+            softrast_box(cmd->x1, cmd->y1, cmd->x2, cmd->y2, cmd->color);
+            break;
+        case DC_CIRCLE:
+            softrast_circle(cmd->x1, cmd->y1, cmd->x2, cmd->color);
+            break;
+        case DC_FILLED_CIRCLE:
+            softrast_filled_circle(cmd->x1, cmd->y1, cmd->x2, cmd->color);
+            break;
+        case DC_POINTS:
+            softrast_points(&points[cmd->first], cmd->count, cmd->color);
+            break;
+        }
+    }
+
+    softrast_flush();
+}
+
+static void sdl_submit(void)
+{
+    Uint32 cur_color = 0;
+    int color_set = 0;
+    DrawLayer layer = DL_LAYER_SCENE;
+
+    for (int i = 0; i < ncmds; i++) {
+        DrawCmd *cmd = &cmds[order[i]];
+
+        if (cmd->layer != layer) {
+            geo_submit();
+            layer = cmd->layer;
+        }
+
+        if (!cmd_is_hairline(cmd)) {
+            geo_append(cmd);
+            continue;
+        }
+
+        // hairlines of a layer are sorted after its geometry
+        geo_submit();
+
+        Uint32 key = color_key(cmd->color);
+        if (!color_set || key != cur_color) {
+            SDL_SetRenderDrawColor(renderer, cmd->color.r, cmd->color.g,
+                                   cmd->color.b, cmd->color.a);
+            cur_color = key;
+            color_set = 1;
+        }
+        if (cmd->type == DC_CIRCLE) {
+            int n = circle_segments(cmd->x2);
+            scratch = grow(scratch, &scratch_cap, n + 1, sizeof(*scratch));
+            circle_points(scratch, n, cmd->x1, cmd->y1, cmd->x2);
+            SDL_RenderDrawLinesF(renderer, scratch, n + 1);
+        } else if (cmd->type == DC_POINTS) {
+            SDL_RenderDrawPointsF(renderer, &points[cmd->first], cmd->count);
+        } else {
+            SDL_RenderDrawLinesF(renderer, &points[cmd->first], cmd->count);
+        }
+    }
+    geo_submit();
+}
+
+void dl_flush(void)
+{
+    PROF_BEGIN(PROF_DRAWLIST);
+
+    if (open_strip >= 0)
+        dl_polyline_end();
+
+    order = grow(order, &order_cap, ncmds, sizeof(*order));
+    for (int i = 0; i < ncmds; i++)
+        order[i] = i;
+    // the compositor flushes once per layer, often with nothing queued
+    if (ncmds > 1)
+        qsort(order, ncmds, sizeof(*order), cmd_compare);
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    if (backend == DL_BACKEND_SOFT)
+        soft_submit();
+    else
+        sdl_submit();
+
+    ncmds = 0;
+    npoints = 0;
+    cur_layer = DL_LAYER_SCENE;
+    cur_width = 1.f;
+
+    PROF_END(PROF_DRAWLIST);
+}
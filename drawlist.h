@@ -0,0 +1,65 @@
+#ifndef _DRAWLIST_H
+#define _DRAWLIST_H
+
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+/*
+ * Deferred draw commands. Scenes and widgets emit primitives here during the
+ * frame, dl_flush() then submits them in as few renderer calls as possible.
+ * Layers are drawn in order, commands inside a layer may be reordered
+ * (filled/alpha geometry first in submission order, then opaque lines
+ * grouped by color).
+ */
+
+/*
+ * DL_BACKEND_SDL submits through SDL_Renderer, DL_BACKEND_SOFT rasterizes
+ * on the CPU (see softrast.h) and uploads the result once per flush.
+ */
+typedef enum DrawBackend {
+    DL_BACKEND_SDL,
+    DL_BACKEND_SOFT,
+    DL_BACKEND_END,
+} DrawBackend;
+
+bool dl_backend_parse(const char *name, DrawBackend *backend);
+const char *dl_backend_name(DrawBackend backend);
+void dl_set_backend(DrawBackend backend);
+DrawBackend dl_backend(void);
+
+typedef enum DrawLayer {
+    DL_LAYER_SCENE,
+    DL_LAYER_WIDGETS,
+    DL_LAYER_OVERLAY,
+    DL_LAYER_END,
+} DrawLayer;
+
+void dl_layer(DrawLayer layer);
+void dl_line_width(float width);
+
+void dl_polyline_begin(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void dl_vertex(float x, float y);
+void dl_polyline_end(void);
+
+void dl_line(float x1, float y1, float x2, float y2,
+             Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void dl_rect(float x1, float y1, float x2, float y2,
+             Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void dl_box(float x1, float y1, float x2, float y2,
+            Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void dl_circle(float x, float y, float rad,
+               Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void dl_filled_circle(float x, float y, float rad,
+                      Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+/*
+ * One command for n points given as separate coordinate arrays, which are
+ * copied. Points are a pixel, or a square of the line width.
+ */
+void dl_points(const float *x, const float *y, int n,
+               Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+void dl_flush(void);
+
+#endif /* _DRAWLIST_H */
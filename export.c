@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "export.h"
+#include "simstate.h"
+#include "draw.h"
+#include "drawlist.h"
+#include "text.h"
+#include "sim.h"
+#include "config.h"
+
+extern SDL_Renderer *renderer;
+
+/*
+ * The render thread reads every frame back into one of EXPORT_BUFFERS
+ * staging buffers and hands it to a writer thread, which converts and writes
+ * it while the next frames are rendered. Two semaphores pass the buffers back
+ * and forth, the render thread only waits when all of them are queued.
+ */
+
+#define EXPORT_W CONFIG_WINDOW_WIDTH
+#define EXPORT_H CONFIG_WINDOW_HEIGHT
+
+typedef enum ExportFormat {
+    EXPORT_Y4M,
+    EXPORT_PPM,
+} ExportFormat;
+
+typedef struct ExportState {
+    FILE *out;
+    ExportFormat format;
+    int frames;
+
+    Uint32 *staging[EXPORT_BUFFERS];
+    SDL_sem *free_bufs;
+    SDL_sem *full_bufs;
+
+    unsigned char *encoded;
+    size_t encoded_size;
+    bool failed;
+} ExportState;
+
+static Scene *find_scene(const char *name)
+{
+    for (int i = 0; i < SCENE_END; i++)
+        if (!strcmp(SCENES[i].name, name))
+            return &SCENES[i];
+
+    return NULL;
+}
+
+static bool ends_with(const char *s, const char *suffix)
+{
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && !strcmp(s + n - m, suffix);
+}
+
+static void encode_ppm(unsigned char *dst, const Uint32 *px)
+{
+    for (int i = 0; i < EXPORT_W * EXPORT_H; i++) {
+        *dst++ = px[i] >> 16;
+        *dst++ = px[i] >> 8;
+        *dst++ = px[i];
+    }
+}
+
+/* BT.601 full range (C420jpeg), chroma averaged over 2x2 blocks */
+static void encode_y4m(unsigned char *dst, const Uint32 *px)
+{
+    unsigned char *y_plane = dst;
+    unsigned char *u_plane = y_plane + EXPORT_W * EXPORT_H;
+    unsigned char *v_plane = u_plane + (EXPORT_W / 2) * (EXPORT_H / 2);
+
+    for (int i = 0; i < EXPORT_W * EXPORT_H; i++) {
+        int r = (px[i] >> 16) & 0xff, g = (px[i] >> 8) & 0xff, b = px[i] & 0xff;
+        y_plane[i] = (77*r + 150*g + 29*b + 128) >> 8;
+    }
+
+    for (int y = 0; y < EXPORT_H / 2; y++) {
+        const Uint32 *row0 = px + (size_t)(2*y) * EXPORT_W;
+        const Uint32 *row1 = row0 + EXPORT_W;
+
+        for (int x = 0; x < EXPORT_W / 2; x++) {
+            Uint32 p[4] = { row0[2*x], row0[2*x + 1], row1[2*x], row1[2*x + 1] };
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; k++) {
+                r += (p[k] >> 16) & 0xff;
+                g += (p[k] >> 8) & 0xff;
+                b += p[k] & 0xff;
+            }
+
+            // sums of four pixels, hence the extra >> 2
+            int u = (-43*r - 85*g + 128*b + (128 << 10) + 512) >> 10;
+            int v = (128*r - 107*g - 21*b + (128 << 10) + 512) >> 10;
+            u_plane[y * (EXPORT_W / 2) + x] = u > 255 ? 255 : u;
+            v_plane[y * (EXPORT_W / 2) + x] = v > 255 ? 255 : v;
+        }
+    }
+}
+
+static int export_writer(void *data)
+{
+    ExportState *ex = data;
+
+    if (ex->format == EXPORT_Y4M)
+        fprintf(ex->out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", EXPORT_W, EXPORT_H, CONFIG_FPS);
+
+    for (int f = 0; f < ex->frames; f++) {
+        SDL_SemWait(ex->full_bufs);
+        const Uint32 *px = ex->staging[f % EXPORT_BUFFERS];
+
+        if (ex->format == EXPORT_Y4M) {
+            encode_y4m(ex->encoded, px);
+            fputs("FRAME\n", ex->out);
+        } else {
+            encode_ppm(ex->encoded, px);
+            fprintf(ex->out, "P6\n%d %d\n255\n", EXPORT_W, EXPORT_H);
+        }
+        SDL_SemPost(ex->free_bufs);
+
+        if (!ex->failed && fwrite(ex->encoded, 1, ex->encoded_size, ex->out) != ex->encoded_size) {
+            perror("export: write");
+            ex->failed = true;
+        }
+    }
+
+    return 0;
+}
+
+static void export_render(Scene *scene, Uint32 *dst)
+{
+    SDL_SetRenderDrawColor(renderer, 18, 18, 18, 255);
+    SDL_RenderClear(renderer);
+
+    draw_scene(scene);
+    dl_flush();
+    text_flush();
+
+    if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, dst, EXPORT_W * 4)) {
+        fprintf(stderr, "sdl error: RenderReadPixels: %s\n", SDL_GetError());
+        exit(1);
+    }
+}
+
+int export_run(const char *scene_name, int frames, const char *path)
+{
+    Scene *scene = find_scene(scene_name);
+    if (!scene) {
+        fprintf(stderr, "export: no scene named '%s'\n", scene_name);
+        return 1;
+    }
+
+    ExportState ex = {
+        .frames = frames,
+        .format = ends_with(path, ".ppm") ? EXPORT_PPM : EXPORT_Y4M,
+    };
+
+    ex.out = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+    if (!ex.out) {
+        perror(path);
+        return 1;
+    }
+    setvbuf(ex.out, NULL, _IOFBF, 1 << 20);
+
+    ex.encoded_size = ex.format == EXPORT_Y4M ? EXPORT_W * EXPORT_H * 3 / 2 : EXPORT_W * EXPORT_H * 3;
+    ex.encoded = malloc(ex.encoded_size);
+    for (int i = 0; i < EXPORT_BUFFERS; i++)
+        ex.staging[i] = malloc(sizeof(Uint32) * EXPORT_W * EXPORT_H);
+    for (int i = 0; i < EXPORT_BUFFERS; i++) {
+        if (!ex.encoded || !ex.staging[i]) {
+            fprintf(stderr, "export: out of memory\n");
+            exit(1);
+        }
+    }
+
+    ex.free_bufs = SDL_CreateSemaphore(EXPORT_BUFFERS);
+    ex.full_bufs = SDL_CreateSemaphore(0);
+    SDL_Thread *writer = SDL_CreateThread(export_writer, "export", &ex);
+    if (!ex.free_bufs || !ex.full_bufs || !writer) {
+        fprintf(stderr, "sdl error: export: %s\n", SDL_GetError());
+        exit(1);
+    }
+
+    SIM_STATE.sel_scene = scene;
+    sim_select_scene(scene);
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 stalled = 0;
+    int ticks = 0;
+
+    for (int f = 0; f < frames; f++) {
+        // sim steps due by the end of this frame, independent of wall time
+        int due = (int)((long long)(f + 1) * CONFIG_SIM_HZ / CONFIG_FPS);
+        for (; ticks < due; ticks++)
+            sim_tick();
+
+        Uint64 wait = SDL_GetPerformanceCounter();
+        SDL_SemWait(ex.free_bufs);
+        stalled += SDL_GetPerformanceCounter() - wait;
+
+        export_render(scene, ex.staging[f % EXPORT_BUFFERS]);
+        SDL_SemPost(ex.full_bufs);
+    }
+
+    SDL_WaitThread(writer, NULL);
+    double secs = (double)(SDL_GetPerformanceCounter() - start) / freq;
+
+    if (ex.out != stdout)
+        fclose(ex.out);
+    else
+        fflush(stdout);
+
+    fprintf(stderr, "export: %d frames of %s in %.2f s (%.1f fps, %.1fx real time), render stalled %.2f s\n",
+            frames, scene->name, secs, frames / secs, frames / secs / CONFIG_FPS,
+            (double)stalled / freq);
+
+    SDL_DestroySemaphore(ex.free_bufs);
+    SDL_DestroySemaphore(ex.full_bufs);
+    for (int i = 0; i < EXPORT_BUFFERS; i++)
+        free(ex.staging[i]);
+    free(ex.encoded);
+
+    return ex.failed;
+}
@@ -0,0 +1,15 @@
+#ifndef _EXPORT_H
+#define _EXPORT_H
+
+/*
+ * Offline export: renders a scene headless for a fixed number of frames,
+ * advancing the sim by exactly CONFIG_SIM_HZ/CONFIG_FPS steps per frame, and
+ * streams the frames as Y4M (4:2:0) or, for paths ending in .ppm, as a
+ * sequence of binary PPMs. A path of "-" writes to stdout.
+ */
+
+#define EXPORT_BUFFERS 4
+
+int export_run(const char *scene_name, int frames, const char *path);
+
+#endif /* _EXPORT_H */
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "fdm.h"
+#include "pool.h"
+
+/*
+ * Work is split into bands of FDM_BAND_ROWS rows. When there are fewer bands
+ * than FDM_TASKS_PER_THREAD per pool thread (always for a string, which is a
+ * single row) every band is also cut into column slices of at least
+ * FDM_BLOCK_W cells, one pool task per band and slice. Inside a task the rows
+ * are swept in column blocks of FDM_BLOCK_W cells so the three rows of u a
+ * block reads stay in L1 while it moves down the band.
+ */
+#define FDM_BAND_ROWS 32
+#define FDM_BLOCK_W 1024
+#define FDM_TASKS_PER_THREAD 2
+
+// below this many cells a step is cheaper than waking the pool
+#define FDM_PARALLEL_CELLS (1 << 16)
+
+typedef struct FdmCoeffs {
+    float k_cur, k_prev, k_lap;
+} FdmCoeffs;
+
+typedef struct FdmJob {
+    FdmGrid *g;
+    FdmCoeffs c;
+    int slices; // column slices per band
+} FdmJob;
+
+static const char *boundary_names[FDM_BOUNDARY_END] = {
+    [FDM_FIXED] = "fixed",
+    [FDM_FREE] = "free",
+    [FDM_PERIODIC] = "periodic",
+};
+
+const char *fdm_boundary_name(FdmBoundary boundary)
+{
+    return boundary_names[boundary];
+}
+
+void fdm_init(FdmGrid *g, int w, int h)
+{
+    g->w = w;
+    g->h = h;
+    g->stride = w + 2;
+
+    size_t cells = (size_t)g->stride * (h + 2);
+    g->u = calloc(cells, sizeof(float));
+    g->u_prev = calloc(cells, sizeof(float));
+    if (!g->u || !g->u_prev) {
+        fprintf(stderr, "fdm: out of memory\n");
+        exit(1);
+    }
+}
+
+void fdm_free(FdmGrid *g)
+{
+    free(g->u);
+    free(g->u_prev);
+    g->u = g->u_prev = NULL;
+}
+
+void fdm_clear(FdmGrid *g)
+{
+    size_t cells = (size_t)g->stride * (g->h + 2);
+    memset(g->u, 0, cells * sizeof(float));
+    memset(g->u_prev, 0, cells * sizeof(float));
+}
+
+void fdm_pulse(FdmGrid *g, float cx, float cy, float radius, float amplitude)
+{
+    int r = (int)(radius * 3);
+    float inv = 1 / (radius * radius);
+
+    for (int y = (int)cy - r; y <= (int)cy + r; y++) {
+        if (y < 0 || y >= g->h)
+            continue;
+
+        for (int x = (int)cx - r; x <= (int)cx + r; x++) {
+            if (x < 0 || x >= g->w)
+                continue;
+
+            float dx = x - cx, dy = g->h > 1 ? y - cy : 0;
+            float v = amplitude * expf(-(dx*dx + dy*dy) * inv);
+
+            // same displacement in both steps, so it starts at rest
+            size_t i = (size_t)(y + 1) * g->stride + x + 1;
+            g->u[i] += v;
+            g->u_prev[i] += v;
+        }
+    }
+}
+
+static void fdm_ghosts(FdmGrid *g, FdmBoundary boundary)
+{
+    float *u = g->u;
+    int w = g->w, h = g->h, s = g->stride;
+
+    for (int y = 1; y <= h; y++) {
+        float *row = &u[(size_t)y * s];
+        switch (boundary) {
+        case FDM_FIXED:
+            row[0] = row[w+1] = 0;
+            break;
+        case FDM_FREE:
+            row[0] = row[1];
+            row[w+1] = row[w];
+            break;
+        default:
+            row[0] = row[w];
+            row[w+1] = row[1];
+            break;
+        }
+    }
+
+    if (h == 1)
+        return;
+
+    float *top = &u[0], *first = &u[s];
+    float *bottom = &u[(size_t)(h + 1) * s], *last = &u[(size_t)h * s];
+    switch (boundary) {
+    case FDM_FIXED:
+        memset(top, 0, s * sizeof(float));
+        memset(bottom, 0, s * sizeof(float));
+        break;
+    case FDM_FREE:
+        memcpy(top, first, s * sizeof(float));
+        memcpy(bottom, last, s * sizeof(float));
+        break;
+    default:
+        memcpy(top, last, s * sizeof(float));
+        memcpy(bottom, first, s * sizeof(float));
+        break;
+    }
+}
+
+static void fdm_row_1d(float *restrict next, const float *restrict u,
+                       int n, FdmCoeffs c)
+{
+    for (int x = 0; x < n; x++)
+        next[x] = c.k_cur*u[x] - c.k_prev*next[x] + c.k_lap*(u[x-1] + u[x+1]);
+}
+
+static void fdm_row_2d(float *restrict next, const float *restrict u,
+                       const float *restrict up, const float *restrict down,
+                       int n, FdmCoeffs c)
+{
+    for (int x = 0; x < n; x++)
+        next[x] = c.k_cur*u[x] - c.k_prev*next[x] +
+                  c.k_lap*(u[x-1] + u[x+1] + up[x] + down[x]);
+}
+
+static void fdm_band(void *ctx, int task)
+{
+    const FdmJob *job = ctx;
+    FdmGrid *g = job->g;
+    int s = g->stride;
+
+    int band = task / job->slices, slice = task % job->slices;
+
+    int y0 = band * FDM_BAND_ROWS + 1;
+    int y1 = y0 + FDM_BAND_ROWS < g->h + 1 ? y0 + FDM_BAND_ROWS : g->h + 1;
+    int x_begin = 1 + (int)((long long)g->w * slice / job->slices);
+    int x_end = 1 + (int)((long long)g->w * (slice + 1) / job->slices);
+
+    for (int x0 = x_begin; x0 < x_end; x0 += FDM_BLOCK_W) {
+        int n = x_end - x0 < FDM_BLOCK_W ? x_end - x0 : FDM_BLOCK_W;
+
+        for (int y = y0; y < y1; y++) {
+            size_t i = (size_t)y * s + x0;
+
+            if (g->h == 1)
+                fdm_row_1d(&g->u_prev[i], &g->u[i], n, job->c);
+            else
+                fdm_row_2d(&g->u_prev[i], &g->u[i], &g->u[i - s], &g->u[i + s], n, job->c);
+        }
+    }
+}
+
+void fdm_step(FdmGrid *g, double courant, double damping, FdmBoundary boundary)
+{
+    double limit = g->h == 1 ? 1 : M_SQRT1_2;
+    double c2 = courant > limit ? limit*limit : courant*courant;
+    double neighbours = g->h == 1 ? 2 : 4;
+    double gamma = damping / 2;
+
+    // u' = ((2 - n c^2) u - (1 - gamma) u_prev + c^2 sum(neighbours)) / (1 + gamma)
+    FdmJob job = {
+        .g = g,
+        .c = {
+            .k_cur = (2 - neighbours*c2) / (1 + gamma),
+            .k_prev = (1 - gamma) / (1 + gamma),
+            .k_lap = c2 / (1 + gamma),
+        },
+    };
+
+    fdm_ghosts(g, boundary);
+
+    int bands = (g->h + FDM_BAND_ROWS - 1) / FDM_BAND_ROWS;
+    if ((size_t)g->w * g->h < FDM_PARALLEL_CELLS) {
+        job.slices = 1;
+        for (int b = 0; b < bands; b++)
+            fdm_band(&job, b);
+    } else {
+        int want = pool_threads() * FDM_TASKS_PER_THREAD;
+        int max_slices = (g->w + FDM_BLOCK_W - 1) / FDM_BLOCK_W;
+
+        job.slices = bands >= want ? 1 : (want + bands - 1) / bands;
+        if (job.slices > max_slices)
+            job.slices = max_slices;
+
+        pool_run(fdm_band, &job, bands * job.slices);
+    }
+
+    float *tmp = g->u;
+    g->u = g->u_prev;
+    g->u_prev = tmp;
+}
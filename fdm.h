@@ -0,0 +1,46 @@
+#ifndef _FDM_H
+#define _FDM_H
+
+/*
+ * Explicit finite difference solver for the 1D and 2D wave equation
+ * (leapfrog in time, 3/5 point stencil in space) with linear damping.
+ * Grids are row major with one ghost cell on every side, the boundary
+ * condition is applied by filling the ghost cells before each step.
+ * A grid with h == 1 is solved as a 1D string.
+ */
+
+typedef enum FdmBoundary {
+    FDM_FIXED,      // u = 0 beyond the edge, waves reflect inverted
+    FDM_FREE,       // zero slope at the edge, waves reflect upright
+    FDM_PERIODIC,   // opposite edges are joined
+    FDM_BOUNDARY_END,
+} FdmBoundary;
+
+typedef struct FdmGrid {
+    int w, h;
+    int stride;     // w + 2
+    float *u;       // current step, including ghost cells
+    float *u_prev;  // previous step, overwritten in place with the next one
+} FdmGrid;
+
+#define FDM_AT(g, x, y) ((g)->u[((y) + 1) * (g)->stride + (x) + 1])
+
+void fdm_init(FdmGrid *g, int w, int h);
+void fdm_free(FdmGrid *g);
+void fdm_clear(FdmGrid *g);
+
+/* Adds a gaussian bump at rest centered on (cx, cy). */
+void fdm_pulse(FdmGrid *g, float cx, float cy, float radius, float amplitude);
+
+/*
+ * Advances one step. courant is c*dt/dx and is clamped to the stability
+ * limit (1 for strings, 1/sqrt(2) for membranes), damping is the fraction of
+ * velocity lost per step. Large grids are split into row bands on the pool,
+ * and into column slices as well when there are too few bands to keep every
+ * thread busy (strings always are).
+ */
+void fdm_step(FdmGrid *g, double courant, double damping, FdmBoundary boundary);
+
+const char *fdm_boundary_name(FdmBoundary boundary);
+
+#endif /* _FDM_H */
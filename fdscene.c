@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "fdscene.h"
+#include "fdm.h"
+#include "drawlist.h"
+#include "text.h"
+#include "sim.h"
+#include "config.h"
+
+extern SDL_Renderer *renderer;
+extern TTF_Font *font_small;
+
+/*
+ * Scenes on top of the finite difference solver: a plucked string and a
+ * square membrane of CONFIG_FDM_GRID^2 cells. Both run several solver steps
+ * per sim tick. Buttons bump a counter the sim compares against the last one
+ * it saw, that way the excitation happens on the sim thread.
+ */
+
+#define STRING_SUBSTEPS 4
+#define STRING_X1 100
+#define STRING_Y (CONFIG_WINDOW_HEIGHT/2)
+
+#define MEMBRANE_SUBSTEPS 2
+#define MEMBRANE_X1 350
+#define MEMBRANE_Y1 160
+#define MEMBRANE_SIZE 720
+
+double STRING_COURANT = DEFAULT_FD_COURANT;
+double STRING_DAMPING = DEFAULT_FD_DAMPING;
+int STRING_BOUNDARY = FDM_FIXED;
+int STRING_PLUCK = 0;
+
+double MEMBRANE_COURANT = DEFAULT_FD_COURANT;
+double MEMBRANE_DAMPING = DEFAULT_FD_DAMPING;
+int MEMBRANE_BOUNDARY = FDM_FIXED;
+int MEMBRANE_DROP = 0;
+
+static FdmGrid string;
+static int string_plucked = -1;
+static int ui_string_pluck = 0;
+static int ui_string_boundary = FDM_FIXED;
+
+static FdmGrid membrane;
+static int membrane_dropped = -1;
+static int ui_membrane_drop = 0;
+static int ui_membrane_boundary = FDM_FIXED;
+
+static SDL_Texture *texture = NULL;
+
+static void string_pluck(void)
+{
+    // triangle pulled up a quarter of the way in
+    int peak = STRING_CELLS / 4;
+
+    fdm_clear(&string);
+    for (int x = 0; x < STRING_CELLS; x++) {
+        float v = x < peak ? (float)x / peak : (float)(STRING_CELLS - x) / (STRING_CELLS - peak);
+        FDM_AT(&string, x, 0) = 150 * v;
+        string.u_prev[string.stride + x + 1] = 150 * v;
+    }
+}
+
+void sim_scene_string()
+{
+    if (!string.u)
+        fdm_init(&string, STRING_CELLS, 1);
+
+    if (string_plucked != STRING_PLUCK) {
+        string_plucked = STRING_PLUCK;
+        string_pluck();
+    }
+
+    for (int i = 0; i < STRING_SUBSTEPS; i++)
+        fdm_step(&string, STRING_COURANT, STRING_DAMPING, STRING_BOUNDARY);
+}
+
+void snap_scene_string(void *snap)
+{
+    StringSnap *ss = snap;
+
+    if (!string.u)
+        fdm_init(&string, STRING_CELLS, 1);
+
+    ss->boundary = STRING_BOUNDARY;
+    for (int x = 0; x < STRING_CELLS; x++)
+        ss->u[x] = FDM_AT(&string, x, 0);
+}
+
+void draw_scene_string(const void *snap)
+{
+    const StringSnap *ss = snap;
+
+    dl_polyline_begin(255, 255, 255, 255);
+    for (int x = 0; x < STRING_CELLS; x++)
+        dl_vertex(STRING_X1 + x, STRING_Y - ss->u[x]);
+    dl_polyline_end();
+
+    char buff[64];
+    snprintf(buff, sizeof(buff), "boundary: %s", fdm_boundary_name(ss->boundary));
+    render_text(buff, 20, CONFIG_WINDOW_HEIGHT - 40, font_small);
+}
+
+void draw_static_string(void)
+{
+    dl_filled_circle(STRING_X1, STRING_Y, 6, 255, 0, 0, 255);
+    dl_filled_circle(STRING_X1 + STRING_CELLS, STRING_Y, 6, 255, 0, 0, 255);
+}
+
+void sim_scene_membrane()
+{
+    if (!membrane.u)
+        fdm_init(&membrane, CONFIG_FDM_GRID, CONFIG_FDM_GRID);
+
+    // every drop lands somewhere else, the first one in the middle
+    if (membrane_dropped != MEMBRANE_DROP) {
+        membrane_dropped = MEMBRANE_DROP;
+
+        unsigned seed = MEMBRANE_DROP * 2654435761u;
+        float cx = MEMBRANE_DROP ? (seed >> 8) % CONFIG_FDM_GRID : CONFIG_FDM_GRID / 2;
+        float cy = MEMBRANE_DROP ? (seed >> 18) % CONFIG_FDM_GRID : CONFIG_FDM_GRID / 2;
+        fdm_pulse(&membrane, cx, cy, CONFIG_FDM_GRID / 64.f, 1);
+    }
+
+    for (int i = 0; i < MEMBRANE_SUBSTEPS; i++)
+        fdm_step(&membrane, MEMBRANE_COURANT, MEMBRANE_DAMPING, MEMBRANE_BOUNDARY);
+}
+
+void snap_scene_membrane(void *snap)
+{
+    MembraneSnap *ms = snap;
+
+    if (!membrane.u)
+        fdm_init(&membrane, CONFIG_FDM_GRID, CONFIG_FDM_GRID);
+
+    // grids larger than the view are point sampled down to it
+    int step = (CONFIG_FDM_GRID + MEMBRANE_VIEW - 1) / MEMBRANE_VIEW;
+
+    ms->boundary = MEMBRANE_BOUNDARY;
+    ms->w = CONFIG_FDM_GRID / step;
+    ms->h = CONFIG_FDM_GRID / step;
+    for (int y = 0; y < ms->h; y++)
+        for (int x = 0; x < ms->w; x++)
+            ms->u[y * ms->w + x] = FDM_AT(&membrane, x * step, y * step);
+}
+
+static Uint32 membrane_color(float v)
+{
+    int c = (int)(v * 4 * 255);
+    c = c < -255 ? -255 : c > 255 ? 255 : c;
+
+    // crests red, troughs blue
+    return c > 0 ? 0xff000000u | c << 16 | (c / 4) << 8
+                 : 0xff000000u | (-c / 4) << 8 | -c;
+}
+
+void draw_scene_membrane(const void *snap)
+{
+    const MembraneSnap *ms = snap;
+
+    if (!texture) {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                    MEMBRANE_VIEW, MEMBRANE_VIEW);
+        if (!texture) {
+            fprintf(stderr, "sdl error: CreateTexture: %s\n", SDL_GetError());
+            exit(1);
+        }
+    }
+
+    SDL_Rect area = { 0, 0, ms->w, ms->h };
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, &area, &pixels, &pitch)) {
+        fprintf(stderr, "sdl error: LockTexture: %s\n", SDL_GetError());
+        exit(1);
+    }
+
+    for (int y = 0; y < ms->h; y++) {
+        Uint32 *row = (Uint32 *)((char *)pixels + (size_t)y * pitch);
+        for (int x = 0; x < ms->w; x++)
+            row[x] = membrane_color(ms->u[y * ms->w + x]);
+    }
+
+    SDL_UnlockTexture(texture);
+
+    SDL_Rect dst = { MEMBRANE_X1, MEMBRANE_Y1, MEMBRANE_SIZE, MEMBRANE_SIZE };
+    SDL_RenderCopy(renderer, texture, &area, &dst);
+    dl_rect(MEMBRANE_X1, MEMBRANE_Y1, MEMBRANE_X1 + MEMBRANE_SIZE, MEMBRANE_Y1 + MEMBRANE_SIZE,
+            255, 255, 255, 255);
+
+    char buff[64];
+    snprintf(buff, sizeof(buff), "%dx%d, boundary: %s",
+             CONFIG_FDM_GRID, CONFIG_FDM_GRID, fdm_boundary_name(ms->boundary));
+    render_text(buff, 20, CONFIG_WINDOW_HEIGHT - 40, font_small);
+}
+
+void callback_string_pluck(void *data)
+{
+    sim_param_set_int(&STRING_PLUCK, ++ui_string_pluck);
+}
+
+void callback_string_boundary(void *data)
+{
+    ui_string_boundary = (ui_string_boundary + 1) % FDM_BOUNDARY_END;
+    sim_param_set_int(&STRING_BOUNDARY, ui_string_boundary);
+}
+
+void callback_membrane_drop(void *data)
+{
+    sim_param_set_int(&MEMBRANE_DROP, ++ui_membrane_drop);
+}
+
+void callback_membrane_boundary(void *data)
+{
+    ui_membrane_boundary = (ui_membrane_boundary + 1) % FDM_BOUNDARY_END;
+    sim_param_set_int(&MEMBRANE_BOUNDARY, ui_membrane_boundary);
+}
@@ -0,0 +1,47 @@
+#ifndef _FDSCENE_H
+#define _FDSCENE_H
+
+#include "config.h"
+
+#define DEFAULT_FD_COURANT 0.5f
+#define DEFAULT_FD_DAMPING 0.002f
+
+#define STRING_CELLS 1200
+#define MEMBRANE_VIEW 512
+
+extern double STRING_COURANT;
+extern double STRING_DAMPING;
+extern int STRING_BOUNDARY;
+extern int STRING_PLUCK;
+
+extern double MEMBRANE_COURANT;
+extern double MEMBRANE_DAMPING;
+extern int MEMBRANE_BOUNDARY;
+extern int MEMBRANE_DROP;
+
+typedef struct StringSnap {
+    int boundary;
+    float u[STRING_CELLS];
+} StringSnap;
+
+typedef struct MembraneSnap {
+    int boundary;
+    int w, h;
+    float u[MEMBRANE_VIEW * MEMBRANE_VIEW];
+} MembraneSnap;
+
+void sim_scene_string();
+void snap_scene_string(void *snap);
+void draw_scene_string(const void *snap);
+void draw_static_string(void);
+
+void sim_scene_membrane();
+void snap_scene_membrane(void *snap);
+void draw_scene_membrane(const void *snap);
+
+void callback_string_pluck(void *data);
+void callback_string_boundary(void *data);
+void callback_membrane_drop(void *data);
+void callback_membrane_boundary(void *data);
+
+#endif /* _FDSCENE_H */
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "fft.h"
+
+void fft_plan_init(FftPlan *plan, int n)
+{
+    int bits = 0;
+    while ((1 << bits) < n)
+        bits++;
+
+    if ((1 << bits) != n) {
+        fprintf(stderr, "fft: size %d is not a power of two\n", n);
+        exit(1);
+    }
+
+    plan->n = n;
+    plan->rev = malloc(sizeof(int) * n);
+    plan->cos_t = malloc(sizeof(float) * (n / 2 + 1));
+    plan->sin_t = malloc(sizeof(float) * (n / 2 + 1));
+    if (!plan->rev || !plan->cos_t || !plan->sin_t) {
+        fprintf(stderr, "fft: out of memory\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < n; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        plan->rev[i] = r;
+    }
+
+    // computed in double, the table is the only source of rounding error
+    for (int i = 0; i <= n / 2; i++) {
+        plan->cos_t[i] = (float)cos(2 * M_PI * i / n);
+        plan->sin_t[i] = (float)sin(2 * M_PI * i / n);
+    }
+}
+
+void fft_plan_free(FftPlan *plan)
+{
+    free(plan->rev);
+    free(plan->cos_t);
+    free(plan->sin_t);
+}
+
+void fft_inverse(const FftPlan *plan, float *re, float *im)
+{
+    int n = plan->n;
+
+    for (int i = 0; i < n; i++) {
+        int j = plan->rev[i];
+        if (j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (int len = 2; len <= n; len *= 2) {
+        int half = len / 2;
+        int stride = n / len;
+
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; k++) {
+                // e^(+2 pi i k / len)
+                float wr = plan->cos_t[k * stride];
+                float wi = plan->sin_t[k * stride];
+
+                int a = start + k, b = a + half;
+                float tr = re[b]*wr - im[b]*wi;
+                float ti = re[b]*wi + im[b]*wr;
+
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
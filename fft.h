@@ -0,0 +1,20 @@
+#ifndef _FFT_H
+#define _FFT_H
+
+/*
+ * In-place iterative radix-2 FFT on split real/imaginary float arrays.
+ * A plan holds the bit reversal permutation and twiddles for one size.
+ */
+typedef struct FftPlan {
+    int n;          // power of two
+    int *rev;
+    float *cos_t, *sin_t; // n/2 twiddles
+} FftPlan;
+
+void fft_plan_init(FftPlan *plan, int n);
+void fft_plan_free(FftPlan *plan);
+
+/* x[k] = sum_m X[m] e^(2 pi i m k / n), unnormalized. */
+void fft_inverse(const FftPlan *plan, float *re, float *im);
+
+#endif /* _FFT_H */
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "field.h"
+#include "wave.h"
+#include "pool.h"
+#include "drawlist.h"
+#include "text.h"
+#include "sim.h"
+#include "config.h"
+
+extern SDL_Renderer *renderer;
+extern TTF_Font *font_small;
+
+/*
+ * Superposition of up to FIELD_MAX_SOURCES point sources evaluated at every
+ * pixel. The field is computed in FIELD_TILE_W x FIELD_TILE_H tiles spread
+ * over the worker pool, each tile accumulates one row of samples in a small
+ * buffer that stays in L1 and writes the colored row straight into a locked
+ * streaming texture. FIELD_RES_DIV trades resolution for time, the texture is
+ * then stretched over the window.
+ */
+
+#define FIELD_TIME_STEP 0.1
+#define FIELD_PERIOD 5.
+
+#define FIELD_TILE_W 128
+#define FIELD_TILE_H 16
+
+#define FIELD_W (CONFIG_WINDOW_WIDTH/res_div)
+#define FIELD_H (CONFIG_WINDOW_HEIGHT/res_div)
+
+int FIELD_SOURCES = DEFAULT_FIELD_SOURCES;
+double FIELD_LAMBDA = DEFAULT_FIELD_LAMBDA;
+int FIELD_INTENSITY = 0;
+int FIELD_RES_DIV = DEFAULT_FIELD_RES_DIV;
+int FIELD_GOV_RES_DIV = 1; // the governor's lower bound on FIELD_RES_DIV
+
+// widget side copies, the sim owns the variables above
+static int ui_sources = DEFAULT_FIELD_SOURCES;
+static int ui_intensity = 0;
+
+static float src_x[FIELD_MAX_SOURCES], src_y[FIELD_MAX_SOURCES];
+static bool sources_ready = false;
+static double field_t = 0;
+
+static SDL_Texture *texture = NULL;
+static int texture_div = 0;
+
+static Uint32 lut[2][256];
+static bool lut_ready = false;
+
+typedef struct FieldJob {
+    const FieldSnap *snap;
+    Uint32 *pixels;
+    int pitch; // in pixels
+    int w, h;
+    int tiles_x;
+    float scale;
+} FieldJob;
+
+/*
+ * The first two sources form the classic symmetric pair around the center,
+ * the rest are scattered with a fixed seed so runs are reproducible.
+ */
+static void sources_init(void)
+{
+    unsigned seed = 0xf1e1d;
+
+    src_x[0] = CONFIG_WINDOW_WIDTH/2 - 100;
+    src_y[0] = CONFIG_WINDOW_HEIGHT/2;
+    src_x[1] = CONFIG_WINDOW_WIDTH/2 + 100;
+    src_y[1] = CONFIG_WINDOW_HEIGHT/2;
+
+    for (int i = 2; i < FIELD_MAX_SOURCES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        src_x[i] = 100 + (seed >> 8) % (CONFIG_WINDOW_WIDTH - 200);
+        seed = seed * 1103515245u + 12345u;
+        src_y[i] = 100 + (seed >> 8) % (CONFIG_WINDOW_HEIGHT - 200);
+    }
+
+    sources_ready = true;
+}
+
+static void lut_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        // amplitude: blue for troughs, red for crests
+        int v = i - 128;
+        Uint8 r = v > 0 ? 2*v : 0;
+        Uint8 b = v < 0 ? -2*v - 1 : 0;
+        Uint8 g = abs(v) / 4;
+        lut[0][i] = 0xff000000u | r << 16 | g << 8 | b;
+
+        // intensity: black to white through teal
+        Uint8 c = i;
+        lut[1][i] = 0xff000000u | (c*c/255) << 16 | c << 8 | (c + c*c/255)/2;
+    }
+
+    lut_ready = true;
+}
+
+void sim_scene_field()
+{
+    if (!sources_ready)
+        sources_init();
+
+    field_t += FIELD_TIME_STEP;
+}
+
+void snap_scene_field(void *snap)
+{
+    FieldSnap *fs = snap;
+
+    if (!sources_ready)
+        sources_init();
+
+    fs->t = field_t;
+    fs->lambda = FIELD_LAMBDA;
+    fs->intensity = FIELD_INTENSITY;
+    fs->res_div = FIELD_RES_DIV > FIELD_GOV_RES_DIV ? FIELD_RES_DIV : FIELD_GOV_RES_DIV;
+
+    fs->nsources = FIELD_SOURCES;
+    for (int i = 0; i < fs->nsources; i++) {
+        fs->src_x[i] = src_x[i];
+        fs->src_y[i] = src_y[i];
+    }
+}
+
+static void field_tile(void *ctx, int task)
+{
+    const FieldJob *job = ctx;
+    const FieldSnap *fs = job->snap;
+    int div = fs->res_div;
+
+    int x0 = (task % job->tiles_x) * FIELD_TILE_W;
+    int y0 = (task / job->tiles_x) * FIELD_TILE_H;
+    int w = job->w - x0 < FIELD_TILE_W ? job->w - x0 : FIELD_TILE_W;
+    int h = job->h - y0 < FIELD_TILE_H ? job->h - y0 : FIELD_TILE_H;
+
+    const Uint32 *colors = lut[fs->intensity];
+    float acc[FIELD_TILE_W];
+
+    for (int y = y0; y < y0 + h; y++) {
+        for (int i = 0; i < w; i++)
+            acc[i] = 0;
+
+        // sample at pixel centers, in field coordinates when downscaled
+        for (int s = 0; s < fs->nsources; s++)
+            wave_radial_accum(acc, w, x0 + 0.5, y + 0.5,
+                              fs->src_x[s] / div, fs->src_y[s] / div,
+                              fs->t, FIELD_PERIOD, fs->lambda / div, 0);
+
+        Uint32 *row = job->pixels + (size_t)y * job->pitch + x0;
+
+        if (fs->intensity) {
+            for (int i = 0; i < w; i++) {
+                float v = acc[i] * job->scale;
+                int idx = (int)(v*v * 255);
+                row[i] = colors[idx > 255 ? 255 : idx];
+            }
+        } else {
+            for (int i = 0; i < w; i++) {
+                int idx = (int)(acc[i] * job->scale * 127.5f + 128);
+                row[i] = colors[idx < 0 ? 0 : idx > 255 ? 255 : idx];
+            }
+        }
+    }
+}
+
+static void field_texture(int res_div)
+{
+    if (texture && texture_div == res_div)
+        return;
+
+    if (texture)
+        SDL_DestroyTexture(texture);
+
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                FIELD_W, FIELD_H);
+    if (!texture) {
+        fprintf(stderr, "sdl error: CreateTexture: %s\n", SDL_GetError());
+        exit(1);
+    }
+
+    texture_div = res_div;
+}
+
+void draw_scene_field(const void *snap)
+{
+    const FieldSnap *fs = snap;
+    int res_div = fs->res_div;
+
+    if (!lut_ready)
+        lut_init();
+
+    field_texture(res_div);
+
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, NULL, &pixels, &pitch)) {
+        fprintf(stderr, "sdl error: LockTexture: %s\n", SDL_GetError());
+        exit(1);
+    }
+
+    FieldJob job = {
+        .snap = fs,
+        .pixels = pixels,
+        .pitch = pitch / 4,
+        .w = FIELD_W, .h = FIELD_H,
+        .tiles_x = (FIELD_W + FIELD_TILE_W - 1) / FIELD_TILE_W,
+        // n random phases add up to about sqrt(n), the symmetric pair peaks at 2
+        .scale = fs->nsources ? 1 / sqrtf(2 * fs->nsources) : 0,
+    };
+    int tiles_y = (FIELD_H + FIELD_TILE_H - 1) / FIELD_TILE_H;
+
+    pool_run(field_tile, &job, job.tiles_x * tiles_y);
+
+    SDL_UnlockTexture(texture);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+
+    for (int i = 0; i < fs->nsources; i++)
+        dl_filled_circle(fs->src_x[i], fs->src_y[i], 6, 255, 255, 255, 255);
+
+    char buff[64];
+    snprintf(buff, sizeof(buff), "%d sources, %s, %d threads",
+             fs->nsources, fs->intensity ? "intensity" : "amplitude", pool_threads());
+    render_text(buff, 20, CONFIG_WINDOW_HEIGHT - 40, font_small);
+}
+
+void callback_field_add_source(void *data)
+{
+    if (ui_sources < FIELD_MAX_SOURCES)
+        sim_param_set_int(&FIELD_SOURCES, ++ui_sources);
+}
+
+void callback_field_clear_sources(void *data)
+{
+    ui_sources = 0;
+    sim_param_set_int(&FIELD_SOURCES, ui_sources);
+}
+
+void callback_field_toggle_mode(void *data)
+{
+    ui_intensity = !ui_intensity;
+    sim_param_set_int(&FIELD_INTENSITY, ui_intensity);
+}
+
+void knob_field_res(int level)
+{
+    sim_param_set_int(&FIELD_GOV_RES_DIV, level + 1);
+}
@@ -0,0 +1,37 @@
+#ifndef _FIELD_H
+#define _FIELD_H
+
+#define DEFAULT_FIELD_SOURCES 2
+#define DEFAULT_FIELD_LAMBDA 40.f
+#define DEFAULT_FIELD_RES_DIV 1
+
+#define FIELD_MAX_SOURCES 64
+#define FIELD_MAX_RES_DIV 4
+
+extern int FIELD_SOURCES;
+extern double FIELD_LAMBDA;
+extern int FIELD_INTENSITY;
+extern int FIELD_RES_DIV;
+extern int FIELD_GOV_RES_DIV;
+
+typedef struct FieldSnap {
+    double t;
+    double lambda;
+    int intensity;
+    int res_div;
+
+    int nsources;
+    float src_x[FIELD_MAX_SOURCES], src_y[FIELD_MAX_SOURCES];
+} FieldSnap;
+
+void sim_scene_field();
+void snap_scene_field(void *snap);
+void draw_scene_field(const void *snap);
+
+void callback_field_add_source(void *data);
+void callback_field_clear_sources(void *data);
+void callback_field_toggle_mode(void *data);
+
+void knob_field_res(int level);
+
+#endif /* _FIELD_H */
@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "fourier.h"
+#include "fft.h"
+#include "wave.h"
+#include "draw.h"
+#include "drawlist.h"
+#include "text.h"
+#include "sim.h"
+#include "comp.h"
+#include "config.h"
+
+extern TTF_Font *font_small;
+
+/*
+ * Fourier synthesis: one period of sum_m A_m sin(2 pi m x / N + phi_m - m w t)
+ * sampled at N points. Putting A_m e^(i (phi_m - m w t)) in bin m of an
+ * otherwise empty spectrum, the imaginary part of its inverse FFT is exactly
+ * that sum, so a frame costs O(N log N) whatever the number of harmonics.
+ * The harmonics all travel at the same speed, the waveform keeps its shape.
+ */
+
+#define FOURIER_PERIOD 5.
+#define FOURIER_TIME_STEP 0.1
+
+#define FOURIER_X1 350
+#define FOURIER_X2 (CONFIG_WINDOW_WIDTH - 50)
+#define FOURIER_Y (CONFIG_WINDOW_HEIGHT/2)
+#define FOURIER_SCALE 150
+#define FOURIER_TOLERANCE 0.25f
+#define FOURIER_COLS (FOURIER_X2 - FOURIER_X1)
+
+#define FOURIER_BARS_Y 870
+#define FOURIER_BARS_H 120
+
+int FOURIER_HARMONICS = DEFAULT_FOURIER_HARMONICS;
+double FOURIER_GOV_TOLERANCE = 1; // the governor's multiplier on FOURIER_TOLERANCE
+
+// preset changes arrive as generation * FOURIER_PRESET_END + preset
+static int FOURIER_PRESET_REQ = FOURIER_SQUARE;
+
+// index is the harmonic number, written by the sim through the param ring
+static double amp[FOURIER_MAX_HARMONICS + 1], phase[FOURIER_MAX_HARMONICS + 1];
+static int applied_req = -1;
+static double fourier_t = 0;
+
+// widget side mirror, so the editor can show the selected harmonic
+static double ui_amp[FOURIER_MAX_HARMONICS + 1], ui_phase[FOURIER_MAX_HARMONICS + 1];
+static int ui_req = FOURIER_SQUARE;
+static int ui_sel = 1;
+static bool ui_ready = false;
+
+static FftPlan plan;
+static float spec_re[FOURIER_N], spec_im[FOURIER_N];
+static float samples[FOURIER_N];
+static float envelope[2 * FOURIER_COLS];
+static int keep[2 * FOURIER_COLS];
+
+void fourier_preset(double *a, double *p, FourierPreset preset)
+{
+    for (int m = 1; m <= FOURIER_MAX_HARMONICS; m++) {
+        a[m] = 0;
+        p[m] = 0;
+
+        switch (preset) {
+        case FOURIER_SINE:
+            a[m] = m == 1;
+            break;
+        case FOURIER_SQUARE:
+            a[m] = m % 2 ? 4 / (M_PI * m) : 0;
+            break;
+        case FOURIER_SAWTOOTH:
+            a[m] = 2 / (M_PI * m);
+            p[m] = m % 2 ? 0 : M_PI;
+            break;
+        case FOURIER_TRIANGLE:
+            a[m] = m % 2 ? 8 / (M_PI * M_PI * m * m) : 0;
+            p[m] = (m / 2) % 2 ? M_PI : 0;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static double harmonic_phase(double p, int m, double t)
+{
+    return fmod(p - m * 2 * M_PI * t / FOURIER_PERIOD, 2 * M_PI);
+}
+
+void fourier_synth_fft(float *y, const double *a, const double *p, int harmonics, double t)
+{
+    if (!plan.n)
+        fft_plan_init(&plan, FOURIER_N);
+
+    for (int i = 0; i < FOURIER_N; i++)
+        spec_re[i] = spec_im[i] = 0;
+
+    for (int m = 1; m <= harmonics; m++) {
+        double theta = harmonic_phase(p[m], m, t);
+        spec_re[m] = a[m] * cos(theta);
+        spec_im[m] = a[m] * sin(theta);
+    }
+
+    fft_inverse(&plan, spec_re, spec_im);
+
+    for (int i = 0; i < FOURIER_N; i++)
+        y[i] = spec_im[i];
+}
+
+/* O(N*M) reference for the benchmark */
+void fourier_synth_direct(float *y, const double *a, const double *p, int harmonics, double t)
+{
+    for (int i = 0; i < FOURIER_N; i++) {
+        double sum = 0;
+        for (int m = 1; m <= harmonics; m++)
+            sum += a[m] * sin(2 * M_PI * m * i / FOURIER_N + harmonic_phase(p[m], m, t));
+        y[i] = sum;
+    }
+}
+
+/*
+ * The samples outnumber the pixel columns of the curve, so each column is
+ * reduced to its lowest and highest sample in the order they come in before
+ * simplifying. The polyline still covers everything drawn in the column and
+ * the simplification sees at most two values per column whatever FOURIER_N.
+ */
+int fourier_curve(const float *y, float tol, float *x_out, float *y_out)
+{
+    for (int c = 0; c < FOURIER_COLS; c++) {
+        int i0 = c * FOURIER_N / FOURIER_COLS, i1 = (c + 1) * FOURIER_N / FOURIER_COLS;
+        int lo = i0, hi = i0;
+
+        for (int i = i0 + 1; i < i1; i++) {
+            if (y[i] < y[lo])
+                lo = i;
+            if (y[i] > y[hi])
+                hi = i;
+        }
+
+        envelope[2*c] = y[lo < hi ? lo : hi];
+        envelope[2*c + 1] = y[lo < hi ? hi : lo];
+    }
+
+    int n = wave_simplify(envelope, 2 * FOURIER_COLS, FOURIER_SCALE, tol, keep);
+    for (int i = 0; i < n; i++) {
+        x_out[i] = FOURIER_X1 + (float)keep[i] * (FOURIER_X2 - FOURIER_X1) / (2 * FOURIER_COLS - 1);
+        y_out[i] = FOURIER_Y - FOURIER_SCALE * envelope[keep[i]];
+    }
+
+    return n;
+}
+
+void sim_scene_fourier()
+{
+    fourier_t += FOURIER_TIME_STEP;
+}
+
+void snap_scene_fourier(void *snap)
+{
+    FourierSnap *fs = snap;
+
+    if (applied_req != FOURIER_PRESET_REQ) {
+        applied_req = FOURIER_PRESET_REQ;
+        fourier_preset(amp, phase, applied_req % FOURIER_PRESET_END);
+    }
+
+    fs->harmonics = FOURIER_HARMONICS;
+    fourier_synth_fft(samples, amp, phase, fs->harmonics, fourier_t);
+
+    fs->n = fourier_curve(samples, FOURIER_TOLERANCE * FOURIER_GOV_TOLERANCE, fs->x, fs->y);
+
+    for (int m = 1; m <= FOURIER_BARS; m++)
+        fs->bars[m] = m <= fs->harmonics ? amp[m] : 0;
+}
+
+void draw_scene_fourier(const void *snap)
+{
+    const FourierSnap *fs = snap;
+
+    dl_line(FOURIER_X1, FOURIER_Y, FOURIER_X2, FOURIER_Y, 80, 80, 80, 255);
+
+    dl_polyline_begin(255, 255, 255, 255);
+    for (int i = 0; i < fs->n; i++)
+        dl_vertex(fs->x[i], fs->y[i]);
+    dl_polyline_end();
+
+    // amplitudes of the first harmonics
+    float bar_w = (float)(FOURIER_X2 - FOURIER_X1) / FOURIER_BARS;
+    for (int m = 1; m <= FOURIER_BARS; m++) {
+        float h = fabsf(fs->bars[m]) * FOURIER_BARS_H;
+        if (h > FOURIER_BARS_H)
+            h = FOURIER_BARS_H;
+
+        float x = FOURIER_X1 + (m - 1) * bar_w;
+        Uint8 g = m == ui_sel ? 255 : 120;
+        dl_box(x, FOURIER_BARS_Y - h, x + bar_w - 2, FOURIER_BARS_Y, 255, g, 0, 255);
+    }
+
+    char buff[64];
+    snprintf(buff, sizeof(buff), "%d harmonics, %d / %d vertices", fs->harmonics, fs->n, FOURIER_N);
+    render_text(buff, 20, CONFIG_WINDOW_HEIGHT - 40, font_small);
+}
+
+static void editor_sync(void)
+{
+    Widget *widgets = SCENES[SCENE_FOURIER].widgets;
+
+    widgets[FOURIER_AMP_SLIDER].slider_value = ui_amp[ui_sel];
+    widgets[FOURIER_PHASE_SLIDER].slider_value = ui_phase[ui_sel];
+    comp_invalidate_widgets();
+}
+
+void callback_fourier_preset(void *data)
+{
+    FourierPreset preset = (FourierPreset)(intptr_t)data;
+
+    ui_req = (ui_req / FOURIER_PRESET_END + 1) * FOURIER_PRESET_END + preset;
+    sim_param_set_int(&FOURIER_PRESET_REQ, ui_req);
+
+    fourier_preset(ui_amp, ui_phase, preset);
+    ui_ready = true;
+    editor_sync();
+}
+
+static void ui_init(void)
+{
+    if (ui_ready)
+        return;
+
+    fourier_preset(ui_amp, ui_phase, ui_req % FOURIER_PRESET_END);
+    ui_ready = true;
+}
+
+void callback_fourier_select(void *data)
+{
+    Widget *slider = data;
+
+    ui_init();
+    ui_sel = (int)slider->slider_value;
+    editor_sync();
+}
+
+void callback_fourier_amp(void *data)
+{
+    Widget *slider = data;
+
+    ui_init();
+    ui_amp[ui_sel] = slider->slider_value;
+    sim_param_set_double(&amp[ui_sel], ui_amp[ui_sel]);
+}
+
+void callback_fourier_phase(void *data)
+{
+    Widget *slider = data;
+
+    ui_init();
+    ui_phase[ui_sel] = slider->slider_value;
+    sim_param_set_double(&phase[ui_sel], ui_phase[ui_sel]);
+}
+
+void knob_fourier_samples(int level)
+{
+    sim_param_set_double(&FOURIER_GOV_TOLERANCE, 1 << level);
+}
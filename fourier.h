@@ -0,0 +1,52 @@
+#ifndef _FOURIER_H
+#define _FOURIER_H
+
+// samples per period, harmonics up to FOURIER_N/2 - 1 are representable
+#define FOURIER_N 4096
+#define FOURIER_MAX_HARMONICS (FOURIER_N/2 - 1)
+#define FOURIER_BARS 64
+
+#define DEFAULT_FOURIER_HARMONICS 1024
+
+#define FOURIER_HARMONICS_SLIDER 0
+#define FOURIER_SELECT_SLIDER 1
+#define FOURIER_AMP_SLIDER 2
+#define FOURIER_PHASE_SLIDER 3
+
+typedef enum FourierPreset {
+    FOURIER_SINE,
+    FOURIER_SQUARE,
+    FOURIER_SAWTOOTH,
+    FOURIER_TRIANGLE,
+    FOURIER_PRESET_END,
+} FourierPreset;
+
+extern int FOURIER_HARMONICS;
+extern double FOURIER_GOV_TOLERANCE;
+
+#define FOURIER_GOV_LEVELS 4
+
+typedef struct FourierSnap {
+    int harmonics;
+    int n;
+    float x[FOURIER_N], y[FOURIER_N];
+    float bars[FOURIER_BARS + 1];
+} FourierSnap;
+
+void sim_scene_fourier();
+void snap_scene_fourier(void *snap);
+void draw_scene_fourier(const void *snap);
+
+void fourier_preset(double *amp, double *phase, FourierPreset preset);
+void fourier_synth_fft(float *y, const double *amp, const double *phase, int harmonics, double t);
+void fourier_synth_direct(float *y, const double *amp, const double *phase, int harmonics, double t);
+int fourier_curve(const float *y, float tol, float *x_out, float *y_out);
+
+void callback_fourier_preset(void *data);
+void callback_fourier_select(void *data);
+void callback_fourier_amp(void *data);
+void callback_fourier_phase(void *data);
+
+void knob_fourier_samples(int level);
+
+#endif /* _FOURIER_H */
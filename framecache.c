@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "framecache.h"
+
+static atomic_ullong hits, misses, evictions;
+static atomic_llong entries, bytes;
+
+uint64_t framecache_hash(uint64_t h, const void *data, size_t size)
+{
+    // FNV-1a
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+void framecache_init(FrameCache *fc, size_t budget)
+{
+    *fc = (FrameCache) {0};
+    fc->budget = budget;
+}
+
+// what an entry counts against the budget, header included
+static size_t entry_cost(size_t size)
+{
+    return sizeof(FrameCacheEntry) + size;
+}
+
+static FrameCacheEntry **bucket(FrameCache *fc, uint64_t key)
+{
+    return &fc->buckets[key & (FRAMECACHE_BUCKETS - 1)];
+}
+
+static void lru_unlink(FrameCache *fc, FrameCacheEntry *e)
+{
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        fc->head = e->next;
+
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        fc->tail = e->prev;
+}
+
+static void lru_push_front(FrameCache *fc, FrameCacheEntry *e)
+{
+    e->prev = NULL;
+    e->next = fc->head;
+    if (fc->head)
+        fc->head->prev = e;
+    else
+        fc->tail = e;
+    fc->head = e;
+}
+
+static void entry_remove(FrameCache *fc, FrameCacheEntry *e)
+{
+    FrameCacheEntry **link = bucket(fc, e->key);
+    while (*link != e)
+        link = &(*link)->chain;
+    *link = e->chain;
+
+    lru_unlink(fc, e);
+
+    fc->bytes -= entry_cost(e->size);
+    atomic_fetch_sub_explicit(&entries, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&bytes, entry_cost(e->size), memory_order_relaxed);
+    free(e);
+}
+
+void framecache_clear(FrameCache *fc)
+{
+    while (fc->head)
+        entry_remove(fc, fc->head);
+}
+
+void framecache_validate(FrameCache *fc, uint64_t params)
+{
+    if (fc->params == params)
+        return;
+
+    framecache_clear(fc);
+    fc->params = params;
+}
+
+const void *framecache_get(FrameCache *fc, uint64_t key, size_t *size)
+{
+    for (FrameCacheEntry *e = *bucket(fc, key); e; e = e->chain) {
+        if (e->key != key)
+            continue;
+
+        if (fc->head != e) {
+            lru_unlink(fc, e);
+            lru_push_front(fc, e);
+        }
+
+        atomic_fetch_add_explicit(&hits, 1, memory_order_relaxed);
+        if (size)
+            *size = e->size;
+        return e->data;
+    }
+
+    atomic_fetch_add_explicit(&misses, 1, memory_order_relaxed);
+    return NULL;
+}
+
+void *framecache_put(FrameCache *fc, uint64_t key, size_t size)
+{
+    if (entry_cost(size) > fc->budget)
+        return NULL;
+
+    for (FrameCacheEntry *e = *bucket(fc, key); e; e = e->chain) {
+        if (e->key == key) {
+            entry_remove(fc, e);
+            break;
+        }
+    }
+
+    while (fc->bytes + entry_cost(size) > fc->budget) {
+        entry_remove(fc, fc->tail);
+        atomic_fetch_add_explicit(&evictions, 1, memory_order_relaxed);
+    }
+
+    FrameCacheEntry *e = malloc(sizeof(*e) + size);
+    if (!e) {
+        fprintf(stderr, "framecache: out of memory\n");
+        exit(1);
+    }
+
+    e->key = key;
+    e->size = size;
+    e->chain = *bucket(fc, key);
+    *bucket(fc, key) = e;
+    lru_push_front(fc, e);
+
+    fc->bytes += entry_cost(size);
+    atomic_fetch_add_explicit(&entries, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&bytes, entry_cost(size), memory_order_relaxed);
+    return e->data;
+}
+
+void framecache_stats(FrameCacheStats *stats)
+{
+    stats->hits = atomic_load_explicit(&hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&misses, memory_order_relaxed);
+    stats->evictions = atomic_load_explicit(&evictions, memory_order_relaxed);
+    stats->entries = atomic_load_explicit(&entries, memory_order_relaxed);
+    stats->bytes = atomic_load_explicit(&bytes, memory_order_relaxed);
+}
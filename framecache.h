@@ -0,0 +1,59 @@
+#ifndef _FRAMECACHE_H
+#define _FRAMECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Memoization of per-frame scene data for scenes that repeat themselves.
+ * Entries are opaque byte blobs keyed by a 64 bit hash, looked up through a
+ * fixed bucket table and kept on an LRU list. Inserting past the byte budget
+ * evicts from the least recently used end. framecache_validate() drops every
+ * entry when the hash of the parameters the frames were computed with
+ * changes. A cache is only ever used from one thread, the counters are
+ * global and can be read from any thread.
+ */
+
+#define FRAMECACHE_BUCKETS 256
+
+typedef struct FrameCacheEntry {
+    uint64_t key;
+    size_t size;
+    struct FrameCacheEntry *chain;       // next in the same bucket
+    struct FrameCacheEntry *prev, *next; // LRU order, most recent first
+    unsigned char data[];
+} FrameCacheEntry;
+
+typedef struct FrameCache {
+    size_t budget;
+    size_t bytes;
+    uint64_t params;
+
+    FrameCacheEntry *buckets[FRAMECACHE_BUCKETS];
+    FrameCacheEntry *head, *tail;
+} FrameCache;
+
+typedef struct FrameCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t bytes;
+} FrameCacheStats;
+
+#define FRAMECACHE_HASH_INIT 0xcbf29ce484222325ull
+
+uint64_t framecache_hash(uint64_t h, const void *data, size_t size);
+
+void framecache_init(FrameCache *fc, size_t budget);
+void framecache_clear(FrameCache *fc);
+void framecache_validate(FrameCache *fc, uint64_t params);
+
+// NULL on a miss, a hit becomes the most recently used entry
+const void *framecache_get(FrameCache *fc, uint64_t key, size_t *size);
+// room for size bytes under key, NULL when it can never fit the budget
+void *framecache_put(FrameCache *fc, uint64_t key, size_t size);
+
+void framecache_stats(FrameCacheStats *stats);
+
+#endif /* _FRAMECACHE_H */
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "governor.h"
+#include "simstate.h"
+#include "draw.h"
+#include "config.h"
+
+typedef struct GovScene {
+    int level;
+    int knob_level[CONFIG_GOV_MAX_KNOBS];
+    int up_frames;  // frames under budget before trying a higher quality
+    bool probing;   // the last change raised the quality
+} GovScene;
+
+static bool enabled = false;
+static GovScene scenes[SCENE_END];
+
+static Scene *current = NULL;
+static double cost = 0;
+static int settle = 0;
+static int over = 0, under = 0;
+static unsigned long long changes = 0;
+
+bool governor_parse(const char *name, bool *out)
+{
+    if (!strcmp(name, "on") || !strcmp(name, "off")) {
+        *out = !strcmp(name, "on");
+        return true;
+    }
+
+    return false;
+}
+
+static int knob_count(const Scene *scene)
+{
+    int n = 0;
+    while (n < CONFIG_GOV_MAX_KNOBS && scene->knobs[n].name)
+        n++;
+
+    return n;
+}
+
+static int max_level(const Scene *scene)
+{
+    int max = 0;
+    for (int k = 0; k < knob_count(scene); k++)
+        max += scene->knobs[k].levels - 1;
+
+    return max;
+}
+
+/* Sets every knob of the scene to its step at the given level. */
+static void apply_level(Scene *scene, int level)
+{
+    GovScene *gs = &scenes[scene - SCENES];
+    int n = knob_count(scene);
+    int steps[CONFIG_GOV_MAX_KNOBS] = {0};
+
+    // round robin over the knobs that can still go lower
+    for (int k = 0; level > 0; k = (k + 1) % n) {
+        if (steps[k] < scene->knobs[k].levels - 1) {
+            steps[k]++;
+            level--;
+        }
+    }
+
+    for (int k = 0; k < n; k++) {
+        if (steps[k] != gs->knob_level[k]) {
+            gs->knob_level[k] = steps[k];
+            scene->knobs[k].apply(steps[k]);
+        }
+    }
+}
+
+static void set_level(Scene *scene, int level)
+{
+    GovScene *gs = &scenes[scene - SCENES];
+
+    // raising the quality did not hold, wait longer before the next try
+    if (level > gs->level && gs->probing && gs->up_frames < GOV_UP_FRAMES_MAX)
+        gs->up_frames *= 2;
+    gs->probing = level < gs->level;
+
+    gs->level = level;
+    apply_level(scene, level);
+
+    changes++;
+    cost = 0;
+    settle = GOV_SETTLE_FRAMES;
+    over = under = 0;
+}
+
+void governor_init(bool on)
+{
+    enabled = on;
+}
+
+void governor_frame(double cost_ms)
+{
+    if (!enabled)
+        return;
+
+    Scene *scene = SIM_STATE.sel_scene;
+    GovScene *gs = &scenes[scene - SCENES];
+
+    if (!gs->up_frames)
+        gs->up_frames = GOV_UP_FRAMES;
+
+    // a scene keeps its level, but its first frames pay for building caches
+    if (scene != current) {
+        current = scene;
+        cost = 0;
+        settle = GOV_SETTLE_FRAMES;
+        over = under = 0;
+    }
+
+    if (settle > 0) {
+        settle--;
+        return;
+    }
+
+    cost = cost ? cost * (1 - GOV_ALPHA) + cost_ms * GOV_ALPHA : cost_ms;
+
+    double budget = CONFIG_FPS_DELTA;
+    over = cost > budget * CONFIG_GOV_HIGH ? over + 1 : 0;
+    under = cost < budget * CONFIG_GOV_LOW ? under + 1 : 0;
+
+    if (over >= GOV_DOWN_FRAMES && gs->level < max_level(scene))
+        set_level(scene, gs->level + 1);
+    else if (under >= gs->up_frames && gs->level > 0)
+        set_level(scene, gs->level - 1);
+}
+
+void governor_stats(GovernorStats *stats)
+{
+    Scene *scene = SIM_STATE.sel_scene;
+
+    stats->enabled = enabled;
+    stats->scene = scene->name;
+    stats->level = scenes[scene - SCENES].level;
+    stats->max_level = max_level(scene);
+    stats->cost_ms = scene == current ? cost : 0;
+    stats->budget_ms = CONFIG_FPS_DELTA;
+    stats->changes = changes;
+}
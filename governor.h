@@ -0,0 +1,49 @@
+#ifndef _GOVERNOR_H
+#define _GOVERNOR_H
+
+#include <stdbool.h>
+
+/*
+ * Frame budget governor. The main loop reports the time every rendered
+ * frame took up to the present, the governor keeps an exponential moving
+ * average of it and steers a quality level per scene: level 0 is full
+ * quality, every level above lowers one of the scene's knobs by one step,
+ * cycling through the knobs in order. The level goes up after the average
+ * stayed above CONFIG_GOV_HIGH of the frame budget for GOV_DOWN_FRAMES
+ * frames, and down only after it stayed below CONFIG_GOV_LOW for the much
+ * longer GOV_UP_FRAMES. Every time a higher quality had to be given up again
+ * right away that wait doubles, up to GOV_UP_FRAMES_MAX. Measurements right
+ * after a change or a scene switch are ignored for GOV_SETTLE_FRAMES. Knobs
+ * are applied on the main thread and lower quality on top of the sliders,
+ * they never move the sliders.
+ */
+
+#define GOV_ALPHA 0.1
+#define GOV_DOWN_FRAMES 15
+#define GOV_UP_FRAMES 150
+#define GOV_UP_FRAMES_MAX (GOV_UP_FRAMES * 16)
+#define GOV_SETTLE_FRAMES 30
+
+typedef struct GovKnob {
+    const char *name;                // NULL ends the list
+    int levels;                      // steps including full quality
+    void (*apply)(int level);        // 0 is full quality
+} GovKnob;
+
+typedef struct GovernorStats {
+    bool enabled;
+    const char *scene;
+    int level, max_level;
+    double cost_ms;     // moving average
+    double budget_ms;
+    unsigned long long changes;
+} GovernorStats;
+
+bool governor_parse(const char *name, bool *enabled);
+
+void governor_init(bool enabled);
+void governor_frame(double cost_ms);
+
+void governor_stats(GovernorStats *stats);
+
+#endif /* _GOVERNOR_H */
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+#include "input.h"
+#include "simstate.h"
+#include "widgets.h"
+#include "draw.h"
+#include "config.h"
+#include "utils.h"
+
+/*
+ * Widgets are found through a uniform grid of INPUT_CELL sized cells built
+ * once per scene. Every cell lists the widgets whose hit area overlaps it in
+ * array order (compressed, one flat item array plus per cell offsets), so a
+ * lookup only tests the few widgets near the cursor.
+ */
+
+#define INPUT_CELL 64
+#define GRID_W ((CONFIG_WINDOW_WIDTH + INPUT_CELL - 1) / INPUT_CELL)
+#define GRID_H ((CONFIG_WINDOW_HEIGHT + INPUT_CELL - 1) / INPUT_CELL)
+
+typedef struct HitGrid {
+    bool built;
+    int start[GRID_W * GRID_H + 1];
+    int *items;
+} HitGrid;
+
+static HitGrid grids[SCENE_END];
+
+static Widget *captured = NULL;
+static Scene *captured_scene = NULL;
+
+static bool motion_pending = false;
+static int motion_x, motion_y;
+
+static void grid_cells(const Widget *widget, int *cx1, int *cy1, int *cx2, int *cy2)
+{
+    int x1, y1, x2, y2;
+    widget_hit_rect(widget, &x1, &y1, &x2, &y2);
+
+    *cx1 = clamp_int(x1 / INPUT_CELL, 0, GRID_W - 1);
+    *cy1 = clamp_int(y1 / INPUT_CELL, 0, GRID_H - 1);
+    *cx2 = clamp_int(x2 / INPUT_CELL, 0, GRID_W - 1);
+    *cy2 = clamp_int(y2 / INPUT_CELL, 0, GRID_H - 1);
+}
+
+static void grid_build(HitGrid *grid, Scene *scene)
+{
+    static int count[GRID_W * GRID_H];
+    int n = 0;
+
+    while (n < CONFIG_MAX_WIDGETS && scene->widgets[n].widget_type != WIDGET_END)
+        n++;
+
+    for (int c = 0; c < GRID_W * GRID_H; c++)
+        count[c] = 0;
+
+    int cx1, cy1, cx2, cy2;
+    for (int i = 0; i < n; i++) {
+        grid_cells(&scene->widgets[i], &cx1, &cy1, &cx2, &cy2);
+        for (int cy = cy1; cy <= cy2; cy++)
+            for (int cx = cx1; cx <= cx2; cx++)
+                count[cy * GRID_W + cx]++;
+    }
+
+    grid->start[0] = 0;
+    for (int c = 0; c < GRID_W * GRID_H; c++)
+        grid->start[c + 1] = grid->start[c] + count[c];
+
+    grid->items = malloc(sizeof(int) * (grid->start[GRID_W * GRID_H] + 1));
+    if (!grid->items) {
+        fprintf(stderr, "input: out of memory\n");
+        exit(1);
+    }
+
+    for (int c = 0; c < GRID_W * GRID_H; c++)
+        count[c] = grid->start[c];
+
+    for (int i = 0; i < n; i++) {
+        grid_cells(&scene->widgets[i], &cx1, &cy1, &cx2, &cy2);
+        for (int cy = cy1; cy <= cy2; cy++)
+            for (int cx = cx1; cx <= cx2; cx++)
+                grid->items[count[cy * GRID_W + cx]++] = i;
+    }
+
+    grid->built = true;
+}
+
+static Widget *hit_test(Scene *scene, int x, int y)
+{
+    HitGrid *grid = &grids[scene - SCENES];
+
+    if (!grid->built)
+        grid_build(grid, scene);
+
+    if (x < 0 || y < 0 || x >= CONFIG_WINDOW_WIDTH || y >= CONFIG_WINDOW_HEIGHT)
+        return NULL;
+
+    int c = (y / INPUT_CELL) * GRID_W + x / INPUT_CELL;
+    for (int i = grid->start[c]; i < grid->start[c + 1]; i++) {
+        Widget *widget = &scene->widgets[grid->items[i]];
+        if (widget_contains(widget, x, y))
+            return widget;
+    }
+
+    return NULL;
+}
+
+static void input_motion(void)
+{
+    if (!motion_pending)
+        return;
+    motion_pending = false;
+
+    // a scene switch mid drag drops the capture
+    if (captured && captured_scene == SIM_STATE.sel_scene)
+        widget_slider_drag(captured, motion_x);
+}
+
+void input_event(const SDL_Event *ev)
+{
+    switch (ev->type) {
+    case SDL_MOUSEBUTTONDOWN: {
+        input_motion();
+        SIM_STATE.mouse_down = true;
+
+        Scene *scene = SIM_STATE.sel_scene;
+        Widget *widget = hit_test(scene, ev->button.x, ev->button.y);
+        if (!widget)
+            break;
+
+        if (widget->widget_type == WIDGET_SLIDER) {
+            captured = widget;
+            captured_scene = scene;
+        }
+        widget_press(widget, ev->button.x, ev->button.y);
+        break;
+    }
+    case SDL_MOUSEBUTTONUP:
+        input_motion();
+        SIM_STATE.mouse_down = false;
+        captured = NULL;
+        break;
+    case SDL_MOUSEMOTION:
+        if (!captured)
+            break;
+
+        motion_pending = true;
+        motion_x = ev->motion.x;
+        motion_y = ev->motion.y;
+        break;
+    }
+}
+
+void input_frame(void)
+{
+    input_motion();
+}
@@ -0,0 +1,16 @@
+#ifndef _INPUT_H
+#define _INPUT_H
+
+#include <SDL2/SDL.h>
+
+/*
+ * Mouse input for the widgets. Events are fed in as they are polled, motion
+ * is coalesced to the last position and applied once in input_frame(). A
+ * press on a slider captures it until the button is released, so the drag
+ * keeps following the cursor even outside the slider.
+ */
+
+void input_event(const SDL_Event *ev);
+void input_frame(void);
+
+#endif /* _INPUT_H */
@@ -1,9 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_ttf.h>
 #include <GL/glew.h>
 
@@ -14,8 +14,27 @@
 #include "simstate.h"
 #include "config.h"
 #include "draw.h"
+#include "text.h"
+#include "drawlist.h"
+#include "bench.h"
+#include "wave.h"
+#include "check.h"
+#include "sweep.h"
+#include "export.h"
+#include "replay.h"
+#include "sim.h"
+#include "prof.h"
+#include "pool.h"
+#include "comp.h"
+#include "input.h"
+#include "plot.h"
+#include "governor.h"
+#include "pacing.h"
+#include "framecache.h"
+#include "audio.h"
 
 SDL_Window *window;
+SDL_Surface *headless_surface;
 SDL_Renderer *renderer;
 TTF_Font *font;
 TTF_Font *font_small;
@@ -36,10 +55,12 @@ void panic_sdl(const char *msg)
 
 void loop(void)
 {
-#ifndef __EMSCRIPTEN__
-    Uint64 frame_start = SDL_GetTicks64();
-#endif /* __EMSCRIPTEN__ */
+    pacing_frame_begin();
+    replay_record_frame();
+    Uint64 frame_start = SDL_GetPerformanceCounter();
+    PROF_BEGIN(PROF_LOOP);
 
+    PROF_BEGIN(PROF_EVENTS);
     static SDL_Event ev;
     while (SDL_PollEvent(&ev)) {
         switch (ev.type) {
@@ -51,36 +72,72 @@ void loop(void)
             return;
 #endif /* __EMSCRIPTEN__ */
         case SDL_MOUSEBUTTONDOWN:
-            SIM_STATE.mouse_down = true;
-            widget_trigger(ev.button.x, ev.button.y);
-            break;
         case SDL_MOUSEBUTTONUP:
-            SIM_STATE.mouse_down = false;
-            break;
         case SDL_MOUSEMOTION:
-            if (SIM_STATE.mouse_down)
-                widget_update_sliders(ev.button.x, ev.button.y);
+            replay_record_event(&ev);
+            input_event(&ev);
+            break;
+        case SDL_RENDER_TARGETS_RESET:
+        case SDL_RENDER_DEVICE_RESET:
+            comp_invalidate();
+            plot_invalidate_all();
+            break;
+        case SDL_KEYDOWN:
+            if (ev.key.keysym.sym == SDLK_F3)
+                prof_toggle_overlay();
+            else if (ev.key.keysym.sym == SDLK_F4)
+                prof_trace_start("waves-trace.json", CONFIG_PROF_TRACE_FRAMES);
             break;
         }
     }
+    input_frame();
+    PROF_END(PROF_EVENTS);
+
+    sim_update();
+
+    // behind schedule, let the frame go without drawing it
+    if (pacing_skip_render()) {
+        PROF_END(PROF_LOOP);
+        prof_frame_end();
+        pacing_frame_end();
+        return;
+    }
 
     SDL_SetRenderDrawColor(renderer, 18, 18, 18, 255);
     SDL_RenderClear(renderer);
 
     draw_scene(SIM_STATE.sel_scene);
+    prof_draw_overlay();
+    dl_flush();
+    text_flush();
+
+    // the present may block on vsync, it is not part of the frame's cost
+    governor_frame((double)(SDL_GetPerformanceCounter() - frame_start) * 1000 / SDL_GetPerformanceFrequency());
 
+    PROF_BEGIN(PROF_PRESENT);
     SDL_RenderPresent(renderer);
+    PROF_END(PROF_PRESENT);
 
-#ifndef __EMSCRIPTEN__
-    /* limit fps */
-    Uint64 frame_time = SDL_GetTicks64() - frame_start;
-    if (frame_time < CONFIG_FPS_DELTA) {
-        SDL_Delay(CONFIG_FPS_DELTA-frame_time);
-    }
-#endif /* __EMSCRIPTEN__ */
+    PROF_END(PROF_LOOP);
+    prof_frame_end();
+
+    pacing_frame_end();
+}
+
+/* software renderer drawing into a plain surface, needs no video driver */
+void create_headless_renderer(void)
+{
+    headless_surface = SDL_CreateRGBSurfaceWithFormat(0, CONFIG_WINDOW_WIDTH, CONFIG_WINDOW_HEIGHT,
+                                                      32, SDL_PIXELFORMAT_ARGB8888);
+    if (!headless_surface)
+        panic_sdl("CreateRGBSurface");
+
+    renderer = SDL_CreateSoftwareRenderer(headless_surface);
+    if (!renderer)
+        panic_sdl("CreateSoftwareRenderer");
 }
 
-int main()
+void create_window_renderer(void)
 {
     if (SDL_Init(SDL_INIT_VIDEO) < 0)
         panic_sdl("init");
@@ -92,9 +149,112 @@ int main()
     if (!window)
         panic_sdl("CreateWindow");
 
-    renderer = SDL_CreateRenderer(window, -1, 0);
+    Uint32 flags = pacing_mode() == PACING_VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0;
+    renderer = SDL_CreateRenderer(window, -1, flags);
     if (!renderer)
         panic_sdl("CreateRenderer");
+}
+
+void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [--bench [frames]] [--check] [--trace file [frames]] "
+                    "[--pacing timer|vsync|uncapped] [--governor on|off] [--backend sdl|soft] "
+                    "[--audio-driver name] "
+                    "[--export scene frames out.y4m|out.ppm|-] "
+                    "[--sweep model grid out.csv|out.bin|-] "
+                    "[--record file] [--replay file [out.csv|-]]\n", argv0);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    int bench_frames = 0;
+    bool check = false;
+    const char *trace_path = NULL;
+    int trace_frames = CONFIG_PROF_TRACE_FRAMES;
+    PacingMode pacing = PACING_TIMER;
+    bool governor = true;
+    DrawBackend backend = DL_BACKEND_SDL;
+    const char *audio_driver = NULL;
+    const char *export_scene = NULL, *export_path = NULL;
+    int export_frames = 0;
+    const char *sweep_model = NULL, *sweep_grid = NULL, *sweep_path = NULL;
+    const char *record_path = NULL, *replay_path = NULL, *replay_out = NULL;
+
+    // before the sim thread and the worker pool can sample a wave
+    wave_init();
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--bench")) {
+            bench_frames = BENCH_DEFAULT_FRAMES;
+            if (i + 1 < argc && argv[i+1][0] != '-')
+                bench_frames = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--check")) {
+            check = true;
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace_path = argv[++i];
+            if (i + 1 < argc && argv[i+1][0] != '-')
+                trace_frames = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--export") && i + 3 < argc) {
+            export_scene = argv[++i];
+            export_frames = atoi(argv[++i]);
+            export_path = argv[++i];
+        } else if (!strcmp(argv[i], "--sweep") && i + 3 < argc) {
+            sweep_model = argv[++i];
+            sweep_grid = argv[++i];
+            sweep_path = argv[++i];
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+            replay_path = argv[++i];
+            if (i + 1 < argc && (argv[i+1][0] != '-' || !strcmp(argv[i+1], "-")))
+                replay_out = argv[++i];
+        } else if (!strcmp(argv[i], "--pacing") && i + 1 < argc) {
+            if (!pacing_parse(argv[++i], &pacing))
+                usage(argv[0]);
+        } else if (!strcmp(argv[i], "--governor") && i + 1 < argc) {
+            if (!governor_parse(argv[++i], &governor))
+                usage(argv[0]);
+        } else if (!strcmp(argv[i], "--backend") && i + 1 < argc) {
+            if (!dl_backend_parse(argv[++i], &backend))
+                usage(argv[0]);
+        } else if (!strcmp(argv[i], "--audio-driver") && i + 1 < argc) {
+            audio_driver = argv[++i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    // plain computation, no SDL at all
+    if (check)
+        return check_run() ? 1 : 0;
+
+    // nothing is drawn, only the worker pool is needed
+    if (sweep_model) {
+        if (SDL_Init(SDL_INIT_TIMER) < 0)
+            panic_sdl("init");
+
+        pool_init();
+        int ret = sweep_run(sweep_model, sweep_grid, sweep_path);
+        pool_shutdown();
+        SDL_Quit();
+        return ret;
+    }
+
+    bool headless = bench_frames || export_scene || replay_path;
+
+    pacing_init(headless ? PACING_UNCAPPED : pacing);
+    // headless runs measure or reproduce fixed quality, never adapt it
+    governor_init(governor && !headless);
+    dl_set_backend(backend);
+
+    if (headless) {
+        if (SDL_Init(SDL_INIT_TIMER) < 0)
+            panic_sdl("init");
+        create_headless_renderer();
+    } else {
+        create_window_renderer();
+    }
 
     if (TTF_Init())
         panic_sdl("TTF_Init");
@@ -111,12 +271,82 @@ int main()
     if (!font_huge)
         panic_sdl("TTF_OpenFont");
 
+    text_init();
+    pool_init();
+    sim_init();
+
+    // headless runs stay silent unless a driver (e.g. dummy or disk) is asked for
+    if (!headless || audio_driver)
+        audio_init(audio_driver);
+
+    if (trace_path)
+        prof_trace_start(trace_path, trace_frames);
+
+    if (bench_frames) {
+        bench_run(bench_frames);
+        audio_shutdown();
+        pool_shutdown();
+        SDL_Quit();
+        return 0;
+    }
+
+    if (export_scene) {
+        int ret = export_run(export_scene, export_frames, export_path);
+        audio_shutdown();
+        pool_shutdown();
+        SDL_Quit();
+        return ret;
+    }
+
+    if (replay_path) {
+        int ret = replay_run(replay_path, replay_out);
+        audio_shutdown();
+        pool_shutdown();
+        SDL_Quit();
+        return ret;
+    }
+
+    if (record_path && !replay_record_start(record_path))
+        exit(1);
+
+    sim_start();
+
 #ifdef __EMSCRIPTEN__
-    emscripten_set_main_loop(loop, CONFIG_FPS, 1);
+    emscripten_set_main_loop(loop, 0, 1);
 #else
     while (RUN) loop();
 #endif
 
+    sim_stop();
+    replay_record_stop();
+    pool_shutdown();
+
+    AudioStats audio;
+    audio_stats(&audio);
+    if (audio.enabled)
+        fprintf(stderr, "audio: %s, %llu callbacks, %llu underruns, %llu overruns\n", audio.driver,
+                (unsigned long long)audio.callbacks, (unsigned long long)audio.underruns,
+                (unsigned long long)audio.overruns);
+    audio_shutdown();
+
+    PacingStats stats;
+    pacing_stats(&stats);
+    fprintf(stderr, "pacing: %s, %llu frames, %llu missed deadlines, %llu skipped\n",
+            pacing_name(pacing_mode()), (unsigned long long)stats.frames,
+            (unsigned long long)stats.missed, (unsigned long long)stats.skipped);
+
+    GovernorStats gov;
+    governor_stats(&gov);
+    if (gov.enabled)
+        fprintf(stderr, "governor: %llu level changes, %s at level %d/%d\n", gov.changes, gov.scene,
+                gov.level, gov.max_level);
+
+    FrameCacheStats cache;
+    framecache_stats(&cache);
+    fprintf(stderr, "frame cache: %llu hits, %llu misses, %llu evictions\n",
+            (unsigned long long)cache.hits, (unsigned long long)cache.misses,
+            (unsigned long long)cache.evictions);
+
     SDL_DestroyWindow(window);
     SDL_Quit();
     
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "medium.h"
+#include "wave.h"
+#include "pool.h"
+#include "drawlist.h"
+#include "text.h"
+#include "sim.h"
+#include "config.h"
+
+extern TTF_Font *font_small;
+
+/*
+ * The medium a wave travels through, shown as a lattice of particles that
+ * are displaced by wave_func() at their rest position: across the direction
+ * of travel for a transverse wave, along it for a longitudinal one. Rest and
+ * current positions are kept as separate x and y arrays, so the axis that
+ * does not move is drawn straight from the rest array and the other one is
+ * a contiguous run of floats for the vectorized wave_func_points() kernel.
+ * The lattice is updated in bands of MEDIUM_BAND_ROWS rows over the worker
+ * pool and all particles are drawn as a single dl_points() batch. The rest
+ * positions are jittered a little with a fixed seed, a perfect grid would
+ * show moire patterns instead of the compressions.
+ */
+
+#define MEDIUM_TIME_STEP 0.05
+#define MEDIUM_PERIOD 5.
+
+#define MEDIUM_BAND_ROWS 8
+#define MEDIUM_JITTER 0.25f
+#define MEDIUM_TRACERS 8
+
+// lattice area, the transverse displacement may leave it by the amplitude
+#define MEDIUM_X1 40
+#define MEDIUM_X2 (CONFIG_WINDOW_WIDTH - 40)
+#define MEDIUM_Y1 220
+#define MEDIUM_Y2 (CONFIG_WINDOW_HEIGHT - 100)
+
+double MEDIUM_LAMBDA = DEFAULT_MEDIUM_LAMBDA;
+double MEDIUM_AMPLITUDE = DEFAULT_MEDIUM_AMPLITUDE;
+int MEDIUM_LONGITUDINAL = 0;
+int MEDIUM_GOV_DIV = 1;
+
+// widget side copy, the sim owns the variable above
+static int ui_longitudinal = 0;
+
+static double medium_t = 0;
+
+// main thread, rebuilt when the governor changes the density
+static float rest_x[MEDIUM_PARTICLES], rest_y[MEDIUM_PARTICLES];
+static float moved[MEDIUM_PARTICLES];
+static int lattice_div = 0;
+static int cols, rows;
+
+typedef struct MediumJob {
+    const MediumSnap *snap;
+    const float *rest;  // the displaced axis
+} MediumJob;
+
+static void lattice_build(int div)
+{
+    unsigned seed = 0x3ed1u;
+
+    cols = MEDIUM_COLS / div;
+    rows = MEDIUM_ROWS / div;
+
+    float sx = (float)(MEDIUM_X2 - MEDIUM_X1) / cols;
+    float sy = (float)(MEDIUM_Y2 - MEDIUM_Y1) / rows;
+
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int i = r * cols + c;
+
+            seed = seed * 1103515245u + 12345u;
+            float jx = ((seed >> 8) % 1024 / 1023.f * 2 - 1) * MEDIUM_JITTER;
+            seed = seed * 1103515245u + 12345u;
+            float jy = ((seed >> 8) % 1024 / 1023.f * 2 - 1) * MEDIUM_JITTER;
+
+            rest_x[i] = MEDIUM_X1 + (c + 0.5f + jx) * sx;
+            rest_y[i] = MEDIUM_Y1 + (r + 0.5f + jy) * sy;
+        }
+    }
+
+    lattice_div = div;
+}
+
+void sim_scene_medium()
+{
+    medium_t += MEDIUM_TIME_STEP;
+}
+
+void snap_scene_medium(void *snap)
+{
+    MediumSnap *ms = snap;
+
+    ms->t = medium_t;
+    ms->lambda = MEDIUM_LAMBDA;
+    ms->amplitude = MEDIUM_AMPLITUDE;
+    ms->longitudinal = MEDIUM_LONGITUDINAL;
+    ms->div = MEDIUM_GOV_DIV;
+}
+
+static void medium_band(void *ctx, int task)
+{
+    const MediumJob *job = ctx;
+    const MediumSnap *ms = job->snap;
+
+    int r0 = task * MEDIUM_BAND_ROWS;
+    int r1 = r0 + MEDIUM_BAND_ROWS < rows ? r0 + MEDIUM_BAND_ROWS : rows;
+    int first = r0 * cols, n = (r1 - r0) * cols;
+
+    // the wave travels along x, every particle is displaced by the wave at its rest x
+    wave_func_points(&moved[first], &rest_x[first], n,
+                     ms->t, MEDIUM_PERIOD, ms->lambda, ms->amplitude, 0);
+
+    for (int i = first; i < first + n; i++)
+        moved[i] += job->rest[i];
+}
+
+void draw_scene_medium(const void *snap)
+{
+    const MediumSnap *ms = snap;
+
+    if (ms->div != lattice_div)
+        lattice_build(ms->div);
+
+    MediumJob job = {
+        .snap = ms,
+        .rest = ms->longitudinal ? rest_x : rest_y,
+    };
+    pool_run(medium_band, &job, (rows + MEDIUM_BAND_ROWS - 1) / MEDIUM_BAND_ROWS);
+
+    const float *x = ms->longitudinal ? moved : rest_x;
+    const float *y = ms->longitudinal ? rest_y : moved;
+    dl_points(x, y, rows * cols, 120, 190, 255, 255);
+
+    // a few particles of the middle row to follow with the eye
+    for (int k = 0; k < MEDIUM_TRACERS; k++) {
+        int i = rows/2 * cols + (2*k + 1) * cols / (2*MEDIUM_TRACERS);
+        dl_filled_circle(x[i], y[i], 5, 255, 80, 60, 255);
+    }
+
+    char buff[64];
+    snprintf(buff, sizeof(buff), "%d particles, %s, %d threads", rows * cols,
+             ms->longitudinal ? "longitudinal" : "transverse", pool_threads());
+    render_text(buff, 20, CONFIG_WINDOW_HEIGHT - 40, font_small);
+}
+
+void callback_medium_toggle_mode(void *data)
+{
+    ui_longitudinal = !ui_longitudinal;
+    sim_param_set_int(&MEDIUM_LONGITUDINAL, ui_longitudinal);
+}
+
+void knob_medium_particles(int level)
+{
+    sim_param_set_int(&MEDIUM_GOV_DIV, 1 << level);
+}
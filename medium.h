@@ -0,0 +1,34 @@
+#ifndef _MEDIUM_H
+#define _MEDIUM_H
+
+#define DEFAULT_MEDIUM_LAMBDA 200.f
+#define DEFAULT_MEDIUM_AMPLITUDE 15.f
+
+// lattice at full quality, the governor divides both by 2 per level
+#define MEDIUM_COLS 512
+#define MEDIUM_ROWS 240
+#define MEDIUM_PARTICLES (MEDIUM_COLS * MEDIUM_ROWS)
+
+#define MEDIUM_GOV_LEVELS 3
+
+extern double MEDIUM_LAMBDA;
+extern double MEDIUM_AMPLITUDE;
+extern int MEDIUM_LONGITUDINAL;
+extern int MEDIUM_GOV_DIV;
+
+typedef struct MediumSnap {
+    double t;
+    double lambda, amplitude;
+    int longitudinal;
+    int div;
+} MediumSnap;
+
+void sim_scene_medium();
+void snap_scene_medium(void *snap);
+void draw_scene_medium(const void *snap);
+
+void callback_medium_toggle_mode(void *data);
+
+void knob_medium_particles(int level);
+
+#endif /* _MEDIUM_H */
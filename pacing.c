@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "pacing.h"
+#include "config.h"
+
+static const char *mode_names[PACING_END] = {
+    [PACING_TIMER] = "timer",
+    [PACING_VSYNC] = "vsync",
+    [PACING_UNCAPPED] = "uncapped",
+};
+
+static PacingMode mode = PACING_TIMER;
+
+static Uint64 freq;
+static Uint64 period;      // counter ticks per frame
+static Uint64 spin;        // ticks left to the deadline that are spun, not slept
+static Uint64 deadline;
+static Uint64 last_begin;
+
+static int skip_left = 0;
+static bool skipping = false;
+
+static PacingStats stats;
+
+bool pacing_parse(const char *name, PacingMode *out)
+{
+    for (int i = 0; i < PACING_END; i++) {
+        if (!strcmp(name, mode_names[i])) {
+            *out = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char *pacing_name(PacingMode m)
+{
+    return mode_names[m];
+}
+
+void pacing_init(PacingMode m)
+{
+#ifdef __EMSCRIPTEN__
+    // requestAnimationFrame decides when frames run
+    m = PACING_VSYNC;
+#endif
+    mode = m;
+
+    freq = SDL_GetPerformanceFrequency();
+    period = freq / CONFIG_FPS;
+    spin = freq * CONFIG_PACING_SPIN_US / 1000000;
+
+    last_begin = 0;
+    stats = (PacingStats) {0};
+}
+
+PacingMode pacing_mode(void)
+{
+    return mode;
+}
+
+void pacing_frame_begin(void)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (last_begin) {
+        double ms = (double)(now - last_begin) * 1000 / freq;
+        stats.interval_ms = stats.interval_ms ? stats.interval_ms * 0.95 + ms * 0.05 : ms;
+    } else {
+        // startup is not a missed frame
+        deadline = now + period;
+    }
+    last_begin = now;
+
+    skipping = skip_left > 0;
+    if (skipping)
+        skip_left--;
+}
+
+bool pacing_skip_render(void)
+{
+    return skipping;
+}
+
+static void pacing_wait(Uint64 until)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    // SDL_Delay oversleeps by up to a scheduler tick, the rest is spun
+    if (until > now + spin)
+        SDL_Delay((Uint32)((until - now - spin) * 1000 / freq));
+
+    while (SDL_GetPerformanceCounter() < until)
+        ;
+}
+
+void pacing_frame_end(void)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    stats.frames++;
+    if (skipping)
+        stats.skipped++;
+
+    if (mode == PACING_UNCAPPED)
+        return;
+
+    if (mode == PACING_VSYNC) {
+        // present already waited, a frame that took half again the refresh missed one
+        double ms = (double)(now - last_begin) * 1000 / freq;
+        if (stats.interval_ms && ms > stats.interval_ms * 1.5)
+            stats.missed++;
+        return;
+    }
+
+    if (now > deadline) {
+        // a skipped frame is part of catching up on the miss that caused it
+        if (!skipping) {
+            stats.missed++;
+
+            Uint64 behind = (now - deadline) / period;
+            if (behind > CONFIG_PACING_MAX_SKIP) {
+                // too far behind to catch up, start a new chain from now
+                deadline = now + period;
+                return;
+            }
+
+            // whole frames behind are dropped, the rest comes off the next frame's wait
+            skip_left = (int)behind;
+        }
+
+        // keep the chain, the frames after a miss end without waiting until back on it
+        deadline += period;
+        return;
+    }
+
+    pacing_wait(deadline);
+    deadline += period;
+}
+
+void pacing_stats(PacingStats *out)
+{
+    *out = stats;
+}
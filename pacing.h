@@ -0,0 +1,47 @@
+#ifndef _PACING_H
+#define _PACING_H
+
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+/*
+ * Frame pacing for the main loop. PACING_TIMER keeps an absolute deadline
+ * every CONFIG_FPS_DELTA and waits for it with a coarse sleep followed by a
+ * short spin on the performance counter, PACING_VSYNC lets SDL_RenderPresent
+ * block on the display and PACING_UNCAPPED never waits. In every mode a
+ * frame that ends past its deadline counts as missed. The timer keeps its
+ * chain of deadlines after a miss, so the next frames do not wait until the
+ * loop is back on schedule. When it fell whole frames behind, up to
+ * CONFIG_PACING_MAX_SKIP, that many frames also skip rendering to get there
+ * sooner. Further behind, it gives up and starts a new chain.
+ * Emscripten is always paced by requestAnimationFrame.
+ */
+
+typedef enum PacingMode {
+    PACING_TIMER,
+    PACING_VSYNC,
+    PACING_UNCAPPED,
+    PACING_END,
+} PacingMode;
+
+typedef struct PacingStats {
+    Uint64 frames;
+    Uint64 missed;
+    Uint64 skipped;
+    double interval_ms; // smoothed time between frames
+} PacingStats;
+
+bool pacing_parse(const char *name, PacingMode *mode);
+const char *pacing_name(PacingMode mode);
+
+void pacing_init(PacingMode mode);
+PacingMode pacing_mode(void);
+
+void pacing_frame_begin(void);
+bool pacing_skip_render(void);
+void pacing_frame_end(void);
+
+void pacing_stats(PacingStats *stats);
+
+#endif /* _PACING_H */
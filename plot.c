@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "plot.h"
+#include "drawlist.h"
+#include "text.h"
+#include "comp.h"
+#include "utils.h"
+
+extern SDL_Renderer *renderer;
+extern TTF_Font *font_small;
+
+#define PLOT_MAX_PLOTS 8
+#define PLOT_SHRINK 0.25f
+#define PLOT_MIN_PAD 1e-3f
+
+// plots that own a texture, for plot_invalidate_all()
+static Plot *plots[PLOT_MAX_PLOTS];
+static int nplots = 0;
+
+void plot_feed_push(PlotFeed *feed, float value)
+{
+    feed->recent[feed->total % PLOT_FEED_SIZE] = value;
+    feed->total++;
+}
+
+void plot_consume(Plot *plot, const PlotFeed *feed)
+{
+    plot->feed = *feed;
+}
+
+static void plot_setup(Plot *plot, int width, int height)
+{
+    plot->width = clamp_int(width, 2, PLOT_MAX_COLUMNS);
+    plot->height = height > 1 ? height : 1;
+
+    plot->per_col = plot->per_col_max = 1;
+    while (plot->per_col_max * plot->width < plot->history)
+        plot->per_col_max *= 2;
+
+    plot->oldest = plot->count = plot->filled = 0;
+    plot->axis_lo = 0;
+    plot->axis_hi = 1;
+    plot->dirty = 0;
+    plot->ready = true;
+
+    if (nplots < PLOT_MAX_PLOTS)
+        plots[nplots++] = plot;
+}
+
+/* Halves the columns in the zoom phase, where the oldest column is in slot 0. */
+static void plot_merge(Plot *plot)
+{
+    int n = plot->count / 2;
+
+    for (int i = 0; i < n; i++) {
+        plot->lo[i] = fminf(plot->lo[2*i], plot->lo[2*i + 1]);
+        plot->hi[i] = fmaxf(plot->hi[2*i], plot->hi[2*i + 1]);
+        plot->last[i] = plot->last[2*i + 1];
+    }
+
+    // an odd column out continues as the newest, half full
+    plot->filled = 2 * plot->per_col;
+    if (plot->count % 2) {
+        plot->lo[n] = plot->lo[plot->count - 1];
+        plot->hi[n] = plot->hi[plot->count - 1];
+        plot->last[n] = plot->last[plot->count - 1];
+        plot->filled = plot->per_col;
+        n++;
+    }
+
+    plot->per_col *= 2;
+    plot->count = n;
+    plot->redraw_all = true;
+
+    // the time axis label changed
+    comp_invalidate_widgets();
+}
+
+static void plot_push(Plot *plot, float value)
+{
+    if (plot->count == plot->width && plot->filled == plot->per_col) {
+        if (plot->per_col < plot->per_col_max) {
+            plot_merge(plot);
+        } else {
+            plot->oldest = (plot->oldest + 1) % plot->width;
+            plot->count--;
+            plot->redraw_oldest = true; // it lost the column it connected to
+            if (plot->dirty > 0)
+                plot->dirty--;
+        }
+    }
+
+    if (plot->count == 0 || plot->filled == plot->per_col) {
+        int slot = (plot->oldest + plot->count) % plot->width;
+        plot->lo[slot] = plot->hi[slot] = plot->last[slot] = value;
+        plot->count++;
+        plot->filled = 1;
+    } else {
+        int slot = (plot->oldest + plot->count - 1) % plot->width;
+        plot->lo[slot] = fminf(plot->lo[slot], value);
+        plot->hi[slot] = fmaxf(plot->hi[slot], value);
+        plot->last[slot] = value;
+        plot->filled++;
+    }
+
+    if (plot->dirty > plot->count - 1)
+        plot->dirty = plot->count - 1;
+}
+
+static void plot_ingest(Plot *plot)
+{
+    uint64_t total = plot->feed.total;
+    uint64_t from = plot->seen;
+
+    // more than the feed holds arrived since the last frame, the rest is gone
+    if (total - from > PLOT_FEED_SIZE)
+        from = total - PLOT_FEED_SIZE;
+
+    for (uint64_t i = from; i < total; i++)
+        plot_push(plot, plot->feed.recent[i % PLOT_FEED_SIZE]);
+
+    plot->seen = total;
+}
+
+static void plot_autoscale(Plot *plot)
+{
+    if (!plot->count)
+        return;
+
+    float lo = INFINITY, hi = -INFINITY;
+    for (int i = 0; i < plot->count; i++) {
+        int slot = (plot->oldest + i) % plot->width;
+        lo = fminf(lo, plot->lo[slot]);
+        hi = fmaxf(hi, plot->hi[slot]);
+    }
+
+    float pad = fmaxf((hi - lo) * PLOT_MARGIN, fmaxf(fabsf(lo), fabsf(hi)) * PLOT_MARGIN);
+    pad = fmaxf(pad, PLOT_MIN_PAD);
+
+    // hysteresis, a range that still fits and uses a fair part of the axis is kept
+    float span = plot->axis_hi - plot->axis_lo;
+    bool fits = lo >= plot->axis_lo && hi <= plot->axis_hi;
+    if (fits && hi - lo + 2 * pad >= span * PLOT_SHRINK)
+        return;
+
+    plot->axis_lo = lo - pad;
+    plot->axis_hi = hi + pad;
+    plot->redraw_all = true;
+
+    // the value axis labels changed
+    comp_invalidate_widgets();
+}
+
+static int plot_y(const Plot *plot, float value)
+{
+    float k = (value - plot->axis_lo) / (plot->axis_hi - plot->axis_lo);
+    return clamp_int((int)lroundf((1 - k) * (plot->height - 1)), 0, plot->height - 1);
+}
+
+/* Redraws the i-th column from the oldest into its slot of the texture. */
+static void plot_column(const Plot *plot, int i)
+{
+    int slot = (plot->oldest + i) % plot->width;
+    float lo = plot->lo[slot], hi = plot->hi[slot];
+
+    // connect to where the previous column ended
+    if (i > 0) {
+        float prev = plot->last[(slot + plot->width - 1) % plot->width];
+        lo = fminf(lo, prev);
+        hi = fmaxf(hi, prev);
+    }
+
+    SDL_Rect column = { slot, 0, 1, plot->height };
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderFillRect(renderer, &column);
+
+    SDL_SetRenderDrawColor(renderer, plot->r, plot->g, plot->b, 255);
+    SDL_RenderDrawLine(renderer, slot, plot_y(plot, hi), slot, plot_y(plot, lo));
+}
+
+static bool plot_texture(Plot *plot)
+{
+    if (plot->texture)
+        return true;
+
+    if (!SDL_RenderTargetSupported(renderer))
+        return false;
+
+    plot->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                      plot->width, plot->height);
+    if (!plot->texture) {
+        // not fatal, the plot is drawn as a polyline instead
+        fprintf(stderr, "sdl error: plot: CreateTexture: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_SetTextureBlendMode(plot->texture, SDL_BLENDMODE_BLEND);
+    plot->redraw_all = true;
+    return true;
+}
+
+static void plot_update_texture(Plot *plot)
+{
+    SDL_SetRenderTarget(renderer, plot->texture);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    int first = plot->dirty;
+    if (plot->redraw_all) {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        first = 0;
+    } else if (plot->redraw_oldest && first > 0) {
+        plot_column(plot, 0);
+    }
+
+    for (int i = first; i < plot->count; i++)
+        plot_column(plot, i);
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderTarget(renderer, NULL);
+}
+
+void plot_draw(Plot *plot, int x1, int y1, int x2, int y2)
+{
+    if (!plot->ready)
+        plot_setup(plot, x2 - x1, y2 - y1);
+
+    plot_ingest(plot);
+    plot_autoscale(plot);
+
+    if (!plot->count)
+        return;
+
+    if (plot_texture(plot)) {
+        plot_update_texture(plot);
+
+        // oldest column on the left, in the zoom phase the ring starts at slot 0
+        int first = plot->width - plot->oldest < plot->count ? plot->width - plot->oldest : plot->count;
+        SDL_Rect src = { plot->oldest, 0, first, plot->height };
+        SDL_Rect dst = { x1, y1, first, plot->height };
+        SDL_RenderCopy(renderer, plot->texture, &src, &dst);
+
+        if (first < plot->count) {
+            src = (SDL_Rect) { 0, 0, plot->count - first, plot->height };
+            dst = (SDL_Rect) { x1 + first, y1, plot->count - first, plot->height };
+            SDL_RenderCopy(renderer, plot->texture, &src, &dst);
+        }
+    } else {
+        dl_polyline_begin(plot->r, plot->g, plot->b, 255);
+        for (int i = 0; i < plot->count; i++)
+            dl_vertex(x1 + i, y1 + plot_y(plot, plot->last[(plot->oldest + i) % plot->width]));
+        dl_polyline_end();
+    }
+
+    plot->dirty = plot->count;
+    plot->redraw_all = plot->redraw_oldest = false;
+}
+
+void plot_draw_frame(Plot *plot, const char *label, int x1, int y1, int x2, int y2)
+{
+    dl_line(x1, y1, x1, y2, 255, 255, 255, 255);
+    dl_line(x1, y2, x2, y2, 255, 255, 255, 255);
+
+    if (label)
+        render_text(label, x1, y1 - 30, font_small);
+
+    if (!plot->ready || !plot->count)
+        return;
+
+    char buff[32];
+    snprintf(buff, sizeof(buff), "%.4g", plot->axis_hi);
+    render_text(buff, x1 - text_width(buff, font_small) - 8, y1, font_small);
+    snprintf(buff, sizeof(buff), "%.4g", plot->axis_lo);
+    render_text(buff, x1 - text_width(buff, font_small) - 8, y2 - 25, font_small);
+
+    if (plot->rate > 0) {
+        snprintf(buff, sizeof(buff), "%.0f s", plot->per_col * plot->width / plot->rate);
+        render_text(buff, x2 - text_width(buff, font_small), y2, font_small);
+    }
+}
+
+void plot_invalidate_all(void)
+{
+    for (int i = 0; i < nplots; i++)
+        plots[i]->redraw_all = true;
+}
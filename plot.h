@@ -0,0 +1,66 @@
+#ifndef _PLOT_H
+#define _PLOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL2/SDL.h>
+
+/*
+ * Scrolling time-series plot behind WIDGET_PLOT. The sim side appends
+ * samples to a PlotFeed that travels in the scene's snapshot, the draw side
+ * hands it over with plot_consume() and the plot takes the samples it has
+ * not seen yet, at most PLOT_FEED_SIZE per frame. Samples are binned
+ * into one min/max/last envelope per pixel column, kept in a ring of columns,
+ * and the columns are drawn once into a target texture that is used as a
+ * circular buffer: a frame only redraws the columns that changed and shows
+ * the texture with two copies. While the history fills up the time axis
+ * zooms out, pairs of columns are merged and the samples per column double,
+ * up to the first power of two that holds the configured history; after that
+ * the plot scrolls. The value axis follows the data range and is padded by
+ * PLOT_MARGIN, it is only rescaled once the data leaves it or shrinks to a
+ * fraction of it. Rescaling and merging redraw every column, which costs the
+ * width of the plot, never the length of the history.
+ */
+
+#define PLOT_FEED_SIZE 64
+#define PLOT_MAX_COLUMNS 1024
+#define PLOT_MARGIN 0.1f
+
+typedef struct PlotFeed {
+    uint64_t total;
+    float recent[PLOT_FEED_SIZE]; // sample i is at i % PLOT_FEED_SIZE
+} PlotFeed;
+
+typedef struct Plot {
+    int history;    // samples shown at least, once the plot scrolls
+    float rate;     // samples per second, for the time axis label
+    Uint8 r, g, b;
+
+    // main thread state, set up on first use
+    bool ready;
+    int width, height;
+    int per_col, per_col_max;
+    int oldest, count, filled; // ring slot of the oldest column, columns, samples in the newest
+    float lo[PLOT_MAX_COLUMNS], hi[PLOT_MAX_COLUMNS], last[PLOT_MAX_COLUMNS];
+    float axis_lo, axis_hi;
+    PlotFeed feed;
+    uint64_t seen;
+
+    SDL_Texture *texture;
+    bool redraw_all, redraw_oldest;
+    int dirty; // first column, counted from the oldest, the texture is missing
+} Plot;
+
+void plot_feed_push(PlotFeed *feed, float value);
+
+// hands the latest feed to the plot, the next plot_draw() takes the new samples
+void plot_consume(Plot *plot, const PlotFeed *feed);
+
+// x1..y2 is the plot area of the widget
+void plot_draw_frame(Plot *plot, const char *label, int x1, int y1, int x2, int y2);
+void plot_draw(Plot *plot, int x1, int y1, int x2, int y2);
+
+void plot_invalidate_all(void);
+
+#endif /* _PLOT_H */
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include <SDL2/SDL.h>
+
+#include "pool.h"
+#include "config.h"
+#include "prof.h"
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define POOL_THREADED
+#endif
+
+/*
+ * One job slot per thread that may run jobs at the same time, the render
+ * thread and the sim thread. A caller takes the first free slot, so a
+ * render job never waits behind a whole sim job, only behind the tasks the
+ * workers are already running. Waking a worker adds a claim to the slot
+ * before posting the shared semaphore, the woken worker takes any claim and
+ * drains that slot. Claims no worker picked up yet are taken back by the
+ * caller once its own tasks are done.
+ */
+#define POOL_SLOTS 2
+
+typedef struct PoolJob {
+    PoolFn fn;
+    void *ctx;
+    int ntasks;
+    atomic_int next;
+    atomic_int claims;  // wakeups not picked up by a worker yet
+} PoolJob;
+
+static PoolJob jobs[POOL_SLOTS];
+static int nworkers = 0;
+
+#ifdef POOL_THREADED
+static SDL_Thread *workers[CONFIG_POOL_MAX_THREADS];
+static SDL_sem *start;
+static SDL_sem *done[POOL_SLOTS];
+static SDL_mutex *busy[POOL_SLOTS];
+static atomic_bool quit = false;
+#endif
+
+static void pool_drain(PoolJob *job)
+{
+    int task;
+
+    while ((task = atomic_fetch_add(&job->next, 1)) < job->ntasks) {
+        PROF_BEGIN(PROF_POOL_TASK);
+        job->fn(job->ctx, task);
+        PROF_END(PROF_POOL_TASK);
+    }
+}
+
+#ifdef POOL_THREADED
+/* Takes one claim off the slot, false if there is none left. */
+static bool pool_claim(PoolJob *job)
+{
+    int claims = atomic_load(&job->claims);
+
+    while (claims > 0)
+        if (atomic_compare_exchange_weak(&job->claims, &claims, claims - 1))
+            return true;
+
+    return false;
+}
+
+static int pool_worker(void *data)
+{
+    for (;;) {
+        SDL_SemWait(start);
+        if (atomic_load(&quit))
+            break;
+
+        // the claim may have been taken back already, then the wakeup is spurious
+        for (int s = 0; s < POOL_SLOTS; s++) {
+            if (pool_claim(&jobs[s])) {
+                pool_drain(&jobs[s]);
+                SDL_SemPost(done[s]);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+#endif
+
+void pool_init(void)
+{
+#ifdef POOL_THREADED
+    nworkers = SDL_GetCPUCount() - 1;
+    if (nworkers > CONFIG_POOL_MAX_THREADS)
+        nworkers = CONFIG_POOL_MAX_THREADS;
+
+    start = SDL_CreateSemaphore(0);
+    if (!start) {
+        fprintf(stderr, "sdl error: pool: %s\n", SDL_GetError());
+        exit(1);
+    }
+
+    for (int s = 0; s < POOL_SLOTS; s++) {
+        done[s] = SDL_CreateSemaphore(0);
+        busy[s] = SDL_CreateMutex();
+        if (!done[s] || !busy[s]) {
+            fprintf(stderr, "sdl error: pool: %s\n", SDL_GetError());
+            exit(1);
+        }
+    }
+
+    for (int i = 0; i < nworkers; i++) {
+        workers[i] = SDL_CreateThread(pool_worker, "pool", NULL);
+        if (!workers[i]) {
+            fprintf(stderr, "sdl error: CreateThread: %s\n", SDL_GetError());
+            exit(1);
+        }
+    }
+#endif
+}
+
+void pool_shutdown(void)
+{
+#ifdef POOL_THREADED
+    atomic_store(&quit, true);
+
+    for (int i = 0; i < nworkers; i++)
+        SDL_SemPost(start);
+    for (int i = 0; i < nworkers; i++)
+        SDL_WaitThread(workers[i], NULL);
+
+    SDL_DestroySemaphore(start);
+    for (int s = 0; s < POOL_SLOTS; s++) {
+        SDL_DestroySemaphore(done[s]);
+        SDL_DestroyMutex(busy[s]);
+    }
+    nworkers = 0;
+#endif
+}
+
+int pool_threads(void)
+{
+    return nworkers + 1;
+}
+
+void pool_run(PoolFn fn, void *ctx, int ntasks)
+{
+#ifdef POOL_THREADED
+    // a third concurrent caller waits for the first slot
+    int slot = 0;
+    while (slot < POOL_SLOTS && SDL_TryLockMutex(busy[slot]) != 0)
+        slot++;
+    if (slot == POOL_SLOTS)
+        SDL_LockMutex(busy[slot = 0]);
+
+    PoolJob *job = &jobs[slot];
+#else
+    PoolJob *job = &jobs[0];
+#endif
+
+    job->fn = fn;
+    job->ctx = ctx;
+    job->ntasks = ntasks;
+    atomic_store(&job->next, 0);
+
+#ifdef POOL_THREADED
+    // small jobs are not worth waking everyone up for
+    int wake = ntasks - 1 < nworkers ? ntasks - 1 : nworkers;
+
+    atomic_store(&job->claims, wake);
+    for (int i = 0; i < wake; i++)
+        SDL_SemPost(start);
+
+    pool_drain(job);
+
+    // workers busy on the other slot may not have come yet, no need to wait for them
+    while (pool_claim(job))
+        wake--;
+    for (int i = 0; i < wake; i++)
+        SDL_SemWait(done[slot]);
+
+    SDL_UnlockMutex(busy[slot]);
+#else
+    pool_drain(job);
+#endif
+}
@@ -0,0 +1,19 @@
+#ifndef _POOL_H
+#define _POOL_H
+
+/*
+ * Fixed pool of worker threads for data parallel jobs. pool_run() splits a
+ * job into ntasks independent tasks, the workers and the calling thread pull
+ * task indices until none are left, and it returns once every task finished.
+ * The render and the sim thread can run jobs at the same time, a third
+ * concurrent caller waits.
+ */
+typedef void (*PoolFn)(void *ctx, int task);
+
+void pool_init(void);
+void pool_shutdown(void);
+
+int pool_threads(void);
+void pool_run(PoolFn fn, void *ctx, int ntasks);
+
+#endif /* _POOL_H */
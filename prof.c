@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "prof.h"
+#include "config.h"
+
+#if CONFIG_PROFILER
+
+#include "drawlist.h"
+#include "text.h"
+#include "pacing.h"
+#include "framecache.h"
+#include "audio.h"
+#include "governor.h"
+
+extern TTF_Font *font_small;
+
+static const char *zone_names[PROF_END_ZONES] = {
+    [PROF_LOOP] = "loop",
+    [PROF_EVENTS] = "events",
+    [PROF_SIM] = "sim_tick",
+    [PROF_DRAW_SCENE] = "draw_scene",
+    [PROF_DRAWFN] = "drawfn",
+    [PROF_DRAW_WIDGET] = "draw_widget",
+    [PROF_RENDER_TEXT] = "render_text",
+    [PROF_DRAWLIST] = "dl_flush",
+    [PROF_TEXT_FLUSH] = "text_flush",
+    [PROF_PRESENT] = "present",
+    [PROF_POOL_TASK] = "pool_task",
+};
+
+typedef struct ProfEvent {
+    ProfZone zone;
+    SDL_threadID tid;
+    Uint64 start, end;
+} ProfEvent;
+
+atomic_bool prof_enabled = false;
+
+static bool overlay = false;
+
+// time spent in each zone during the current frame, any thread may add to it
+static atomic_uint_fast64_t zone_accum[PROF_END_ZONES];
+
+// per frame zone times of the last CONFIG_PROF_HISTORY frames
+static Uint64 history[PROF_END_ZONES][CONFIG_PROF_HISTORY];
+static int history_pos = 0;
+static int history_len = 0;
+
+static atomic_bool tracing = false;
+static ProfEvent *events;
+static atomic_int events_claimed;
+static atomic_int events_written;
+static int trace_frames_left;
+static char trace_path[256];
+
+static void prof_update_enabled(void)
+{
+    atomic_store(&prof_enabled, overlay || atomic_load(&tracing));
+}
+
+void prof_record(ProfZone zone, Uint64 start)
+{
+    Uint64 end = SDL_GetPerformanceCounter();
+    atomic_fetch_add_explicit(&zone_accum[zone], end - start, memory_order_relaxed);
+
+    if (!atomic_load_explicit(&tracing, memory_order_acquire))
+        return;
+
+    int i = atomic_fetch_add(&events_claimed, 1);
+    if (i < CONFIG_PROF_MAX_EVENTS) {
+        events[i] = (ProfEvent) { .zone = zone, .tid = SDL_ThreadID(),
+                                  .start = start, .end = end };
+    }
+    atomic_fetch_add(&events_written, 1);
+}
+
+void prof_trace_start(const char *path, int frames)
+{
+    if (atomic_load(&tracing))
+        return;
+
+    if (!events) {
+        events = malloc(sizeof(ProfEvent) * CONFIG_PROF_MAX_EVENTS);
+        if (!events) {
+            fprintf(stderr, "prof: out of memory\n");
+            exit(1);
+        }
+    }
+
+    snprintf(trace_path, sizeof(trace_path), "%s", path);
+    trace_frames_left = frames > 0 ? frames : CONFIG_PROF_TRACE_FRAMES;
+    atomic_store(&events_claimed, 0);
+    atomic_store(&events_written, 0);
+
+    atomic_store(&tracing, true);
+    prof_update_enabled();
+}
+
+static void prof_trace_write(void)
+{
+    atomic_store(&tracing, false);
+    prof_update_enabled();
+
+    // wait for zones that claimed a slot before tracing stopped
+    while (atomic_load(&events_written) != atomic_load(&events_claimed))
+        SDL_Delay(0);
+
+    int n = atomic_load(&events_claimed);
+    if (n > CONFIG_PROF_MAX_EVENTS)
+        n = CONFIG_PROF_MAX_EVENTS;
+
+    FILE *f = fopen(trace_path, "w");
+    if (!f) {
+        fprintf(stderr, "prof: can't open %s\n", trace_path);
+        return;
+    }
+
+    Uint64 origin = n ? events[0].start : 0;
+    for (int i = 1; i < n; i++)
+        if (events[i].start < origin)
+            origin = events[i].start;
+
+    double us = 1e6 / SDL_GetPerformanceFrequency();
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < n; i++) {
+        fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                zone_names[events[i].zone], (unsigned long)events[i].tid,
+                (events[i].start - origin) * us, (events[i].end - events[i].start) * us,
+                i + 1 < n ? "," : "");
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+
+    fprintf(stderr, "prof: wrote %d events to %s\n", n, trace_path);
+}
+
+void prof_frame_end(void)
+{
+    if (!atomic_load_explicit(&prof_enabled, memory_order_relaxed))
+        return;
+
+    for (int z = 0; z < PROF_END_ZONES; z++)
+        history[z][history_pos] = atomic_exchange_explicit(&zone_accum[z], 0, memory_order_relaxed);
+
+    history_pos = (history_pos + 1) % CONFIG_PROF_HISTORY;
+    if (history_len < CONFIG_PROF_HISTORY)
+        history_len++;
+
+    if (atomic_load(&tracing) && --trace_frames_left <= 0)
+        prof_trace_write();
+}
+
+void prof_toggle_overlay(void)
+{
+    overlay = !overlay;
+    history_len = 0;
+    history_pos = 0;
+    prof_update_enabled();
+}
+
+#define OV_X 10
+#define OV_Y (CONFIG_WINDOW_HEIGHT - 366)
+#define OV_GRAPH_W (CONFIG_PROF_HISTORY * 3 / 2)
+#define OV_GRAPH_H 100
+#define OV_BUCKETS 24
+
+void prof_draw_overlay(void)
+{
+    if (!overlay || !history_len)
+        return;
+
+    double to_ms = 1000.0 / SDL_GetPerformanceFrequency();
+    double budget = CONFIG_FPS_DELTA;
+    double bar_w = (double)OV_GRAPH_W / CONFIG_PROF_HISTORY;
+
+    dl_layer(DL_LAYER_OVERLAY);
+    dl_box(OV_X, OV_Y, OV_X + OV_GRAPH_W + 330, OV_Y + 356, 0, 0, 0, 200);
+
+    // rolling frame times, oldest on the left, full height is twice the budget
+    int buckets[OV_BUCKETS] = {0};
+    int gy = OV_Y + 10 + OV_GRAPH_H;
+    for (int i = 0; i < history_len; i++) {
+        int idx = (history_pos - history_len + i + CONFIG_PROF_HISTORY) % CONFIG_PROF_HISTORY;
+        double ms = history[PROF_LOOP][idx] * to_ms;
+
+        double h = ms / (2*budget) * OV_GRAPH_H;
+        if (h > OV_GRAPH_H)
+            h = OV_GRAPH_H;
+
+        Uint8 r = ms > budget ? 255 : 80;
+        dl_box(OV_X + 10 + i*bar_w, gy - h, OV_X + 10 + (i+1)*bar_w - 1, gy, r, 200, 80, 255);
+
+        int b = (int)(ms / (2*budget) * OV_BUCKETS);
+        buckets[b < OV_BUCKETS ? b : OV_BUCKETS-1]++;
+    }
+    dl_line(OV_X + 10, gy - OV_GRAPH_H/2, OV_X + 10 + OV_GRAPH_W, gy - OV_GRAPH_H/2, 255, 0, 0, 255);
+
+    // frame time distribution, same scale
+    int hy = gy + 20 + 100;
+    double bucket_w = (double)OV_GRAPH_W / OV_BUCKETS;
+    for (int b = 0; b < OV_BUCKETS; b++) {
+        double h = (double)buckets[b] / history_len * 100;
+        dl_box(OV_X + 10 + b*bucket_w, hy - h, OV_X + 10 + (b+1)*bucket_w - 2, hy, 80, 160, 255, 255);
+    }
+    dl_line(OV_X + 10 + OV_GRAPH_W/2, hy - 100, OV_X + 10 + OV_GRAPH_W/2, hy, 255, 0, 0, 255);
+
+    char buff[64];
+    PacingStats pacing;
+    pacing_stats(&pacing);
+    snprintf(buff, sizeof(buff), "%s %.1f ms, missed %llu, skipped %llu",
+             pacing_name(pacing_mode()), pacing.interval_ms,
+             (unsigned long long)pacing.missed, (unsigned long long)pacing.skipped);
+    render_text(buff, OV_X + 10, hy + 5, font_small);
+
+    FrameCacheStats cache;
+    framecache_stats(&cache);
+    snprintf(buff, sizeof(buff), "cache %llu hit, %llu miss, %llu kB",
+             (unsigned long long)cache.hits, (unsigned long long)cache.misses,
+             (unsigned long long)cache.bytes / 1024);
+    render_text(buff, OV_X + 10, hy + 33, font_small);
+
+    AudioStats audio;
+    audio_stats(&audio);
+    if (audio.enabled)
+        snprintf(buff, sizeof(buff), "audio %s, underruns %llu",
+                 audio.driver, (unsigned long long)audio.underruns);
+    else
+        snprintf(buff, sizeof(buff), "audio off");
+    render_text(buff, OV_X + 10, hy + 61, font_small);
+
+    GovernorStats gov;
+    governor_stats(&gov);
+    if (gov.enabled)
+        snprintf(buff, sizeof(buff), "governor level %d/%d, budget %.0f%%", gov.level, gov.max_level,
+                 gov.cost_ms / gov.budget_ms * 100);
+    else
+        snprintf(buff, sizeof(buff), "governor off");
+    render_text(buff, OV_X + 10, hy + 89, font_small);
+
+    // average time per zone over the history
+    int tx = OV_X + OV_GRAPH_W + 30;
+    for (int z = 0; z < PROF_END_ZONES; z++) {
+        Uint64 sum = 0;
+        for (int i = 0; i < history_len; i++)
+            sum += history[z][i];
+
+        snprintf(buff, sizeof(buff), "%-12s %6.2f ms", zone_names[z], sum * to_ms / history_len);
+        render_text(buff, tx, OV_Y + 5 + z*26, font_small);
+    }
+}
+
+#endif /* CONFIG_PROFILER */
@@ -0,0 +1,61 @@
+#ifndef _PROF_H
+#define _PROF_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include <SDL2/SDL.h>
+
+#include "config.h"
+
+/*
+ * Scoped frame profiler. Zones are opened with PROF_BEGIN(zone) and closed
+ * with PROF_END(zone) in the same block. While neither the overlay nor a trace
+ * capture is active every zone costs one predictable branch, building with
+ * -DCONFIG_PROFILER=0 compiles all of it out.
+ */
+
+typedef enum ProfZone {
+    PROF_LOOP,
+    PROF_EVENTS,
+    PROF_SIM,
+    PROF_DRAW_SCENE,
+    PROF_DRAWFN,
+    PROF_DRAW_WIDGET,
+    PROF_RENDER_TEXT,
+    PROF_DRAWLIST,
+    PROF_TEXT_FLUSH,
+    PROF_PRESENT,
+    PROF_POOL_TASK,
+    PROF_END_ZONES,
+} ProfZone;
+
+#if CONFIG_PROFILER
+
+extern atomic_bool prof_enabled;
+
+#define PROF_BEGIN(zone) \
+    Uint64 prof_start_##zone = atomic_load_explicit(&prof_enabled, memory_order_relaxed) ? \
+        SDL_GetPerformanceCounter() : 0
+#define PROF_END(zone) do { if (prof_start_##zone) prof_record(zone, prof_start_##zone); } while (0)
+
+void prof_record(ProfZone zone, Uint64 start);
+void prof_frame_end(void);
+
+void prof_toggle_overlay(void);
+void prof_draw_overlay(void);
+void prof_trace_start(const char *path, int frames);
+
+#else
+
+#define PROF_BEGIN(zone) do {} while (0)
+#define PROF_END(zone) do {} while (0)
+
+#define prof_frame_end() do {} while (0)
+#define prof_toggle_overlay() do {} while (0)
+#define prof_draw_overlay() do {} while (0)
+#define prof_trace_start(path, frames) do { (void)(path); (void)(frames); } while (0)
+
+#endif /* CONFIG_PROFILER */
+
+#endif /* _PROF_H */
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "replay.h"
+#include "simstate.h"
+#include "draw.h"
+#include "drawlist.h"
+#include "text.h"
+#include "input.h"
+#include "sim.h"
+#include "framecache.h"
+#include "config.h"
+
+extern SDL_Renderer *renderer;
+
+#define REPLAY_W CONFIG_WINDOW_WIDTH
+#define REPLAY_H CONFIG_WINDOW_HEIGHT
+#define REPLAY_HEADER_SIZE 16
+#define REPLAY_RECORD_SIZE 10
+
+typedef struct ReplayEvent {
+    uint32_t frame;
+    uint8_t type, button;
+    int16_t x, y;
+} ReplayEvent;
+
+static FILE *rec = NULL;
+static uint32_t rec_frames = 0;
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void write_event(const ReplayEvent *e)
+{
+    unsigned char buf[REPLAY_RECORD_SIZE];
+
+    put_u32(buf, e->frame);
+    buf[4] = e->type;
+    buf[5] = e->button;
+    buf[6] = (uint16_t)e->x;
+    buf[7] = (uint16_t)e->x >> 8;
+    buf[8] = (uint16_t)e->y;
+    buf[9] = (uint16_t)e->y >> 8;
+
+    if (fwrite(buf, 1, sizeof(buf), rec) != sizeof(buf)) {
+        perror("replay: write");
+        fclose(rec);
+        rec = NULL;
+    }
+}
+
+static void read_event(const unsigned char *buf, ReplayEvent *e)
+{
+    e->frame = get_u32(buf);
+    e->type = buf[4];
+    e->button = buf[5];
+    e->x = (int16_t)(buf[6] | buf[7] << 8);
+    e->y = (int16_t)(buf[8] | buf[9] << 8);
+}
+
+bool replay_record_start(const char *path)
+{
+    rec = fopen(path, "wb");
+    if (!rec) {
+        perror(path);
+        return false;
+    }
+
+    unsigned char header[REPLAY_HEADER_SIZE];
+    memcpy(header, "WREC", 4);
+    put_u32(header + 4, REPLAY_VERSION);
+    put_u32(header + 8, CONFIG_SIM_HZ);
+    put_u32(header + 12, CONFIG_FPS);
+    fwrite(header, 1, sizeof(header), rec);
+
+    rec_frames = 0;
+    return true;
+}
+
+void replay_record_frame(void)
+{
+    rec_frames++;
+}
+
+void replay_record_event(const SDL_Event *ev)
+{
+    if (!rec)
+        return;
+
+    // events belong to the frame that polled them
+    ReplayEvent e = { .frame = rec_frames ? rec_frames - 1 : 0 };
+
+    switch (ev->type) {
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        e.type = ev->type == SDL_MOUSEBUTTONDOWN ? REPLAY_DOWN : REPLAY_UP;
+        e.button = ev->button.button;
+        e.x = ev->button.x;
+        e.y = ev->button.y;
+        break;
+    case SDL_MOUSEMOTION:
+        e.type = REPLAY_MOTION;
+        e.x = ev->motion.x;
+        e.y = ev->motion.y;
+        break;
+    default:
+        return;
+    }
+
+    write_event(&e);
+}
+
+void replay_record_stop(void)
+{
+    if (!rec)
+        return;
+
+    ReplayEvent end = { .frame = rec_frames, .type = REPLAY_END };
+    write_event(&end);
+
+    if (rec && fclose(rec))
+        perror("replay: close");
+    rec = NULL;
+}
+
+static bool load(const char *path, ReplayEvent **out, int *nevents, uint32_t *nframes)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return false;
+    }
+
+    unsigned char header[REPLAY_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) || memcmp(header, "WREC", 4)) {
+        fprintf(stderr, "replay: %s is not a recording\n", path);
+        fclose(in);
+        return false;
+    }
+    if (get_u32(header + 4) != REPLAY_VERSION) {
+        fprintf(stderr, "replay: %s has version %u, expected %d\n", path, get_u32(header + 4), REPLAY_VERSION);
+        fclose(in);
+        return false;
+    }
+    if (get_u32(header + 8) != CONFIG_SIM_HZ || get_u32(header + 12) != CONFIG_FPS)
+        fprintf(stderr, "replay: recorded at %u Hz sim, %u fps, replaying at %d Hz, %d fps\n",
+                get_u32(header + 8), get_u32(header + 12), CONFIG_SIM_HZ, CONFIG_FPS);
+
+    ReplayEvent *events = NULL;
+    int n = 0, cap = 0;
+    bool ended = false;
+    unsigned char buf[REPLAY_RECORD_SIZE];
+
+    *nframes = 0;
+    while (fread(buf, 1, sizeof(buf), in) == sizeof(buf)) {
+        ReplayEvent e;
+        read_event(buf, &e);
+
+        if (e.type == REPLAY_END) {
+            *nframes = e.frame;
+            ended = true;
+            break;
+        }
+
+        if (n == cap) {
+            cap = cap ? cap * 2 : 256;
+            events = realloc(events, sizeof(*events) * cap);
+            if (!events) {
+                fprintf(stderr, "replay: out of memory\n");
+                exit(1);
+            }
+        }
+        events[n++] = e;
+    }
+    fclose(in);
+
+    // a run that was killed has no end record, stop after its last event
+    if (!ended) {
+        fprintf(stderr, "replay: %s is truncated\n", path);
+        *nframes = n ? events[n - 1].frame + 1 : 0;
+    }
+
+    *out = events;
+    *nevents = n;
+    return true;
+}
+
+static void feed(const ReplayEvent *e)
+{
+    SDL_Event ev = {0};
+
+    switch (e->type) {
+    case REPLAY_DOWN:
+    case REPLAY_UP:
+        ev.type = e->type == REPLAY_DOWN ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+        ev.button.button = e->button;
+        ev.button.x = e->x;
+        ev.button.y = e->y;
+        break;
+    case REPLAY_MOTION:
+        ev.type = SDL_MOUSEMOTION;
+        ev.motion.x = e->x;
+        ev.motion.y = e->y;
+        break;
+    default:
+        return;
+    }
+
+    input_event(&ev);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+int replay_run(const char *path, const char *out_path)
+{
+    int nevents;
+    uint32_t nframes;
+    ReplayEvent *events;
+    if (!load(path, &events, &nevents, &nframes))
+        return 1;
+
+    FILE *out = NULL;
+    if (out_path) {
+        out = strcmp(out_path, "-") ? fopen(out_path, "w") : stdout;
+        if (!out) {
+            perror(out_path);
+            free(events);
+            return 1;
+        }
+        fprintf(out, "frame,sim_ns,render_ns,hash\n");
+    }
+
+    Uint32 *pixels = malloc(sizeof(Uint32) * REPLAY_W * REPLAY_H);
+    uint64_t *frame_ns = malloc(sizeof(uint64_t) * (nframes ? nframes : 1));
+    if (!pixels || !frame_ns) {
+        fprintf(stderr, "replay: out of memory\n");
+        exit(1);
+    }
+
+    SIM_STATE.sel_scene = &SCENES[SCENE_MENU];
+    sim_select_scene(SIM_STATE.sel_scene);
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    uint64_t run_hash = FRAMECACHE_HASH_INIT;
+    int ticks = 0, next = 0;
+
+    for (uint32_t f = 0; f < nframes; f++) {
+        Uint64 t0 = SDL_GetPerformanceCounter();
+
+        for (; next < nevents && events[next].frame <= f; next++)
+            feed(&events[next]);
+        input_frame();
+
+        int due = (int)((long long)(f + 1) * CONFIG_SIM_HZ / CONFIG_FPS);
+        for (; ticks < due; ticks++)
+            sim_tick();
+        Uint64 t1 = SDL_GetPerformanceCounter();
+
+        SDL_SetRenderDrawColor(renderer, 18, 18, 18, 255);
+        SDL_RenderClear(renderer);
+        draw_scene(SIM_STATE.sel_scene);
+        dl_flush();
+        text_flush();
+        Uint64 t2 = SDL_GetPerformanceCounter();
+
+        if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, pixels, REPLAY_W * 4)) {
+            fprintf(stderr, "sdl error: RenderReadPixels: %s\n", SDL_GetError());
+            exit(1);
+        }
+        uint64_t hash = framecache_hash(FRAMECACHE_HASH_INIT, pixels, sizeof(Uint32) * REPLAY_W * REPLAY_H);
+        run_hash = framecache_hash(run_hash, &hash, sizeof(hash));
+
+        uint64_t sim_ns = (t1 - t0) * 1000000000ull / freq;
+        uint64_t render_ns = (t2 - t1) * 1000000000ull / freq;
+        frame_ns[f] = sim_ns + render_ns;
+
+        if (out)
+            fprintf(out, "%u,%llu,%llu,%016llx\n", f, (unsigned long long)sim_ns,
+                    (unsigned long long)render_ns, (unsigned long long)hash);
+    }
+
+    int ret = 0;
+    if (out && out != stdout) {
+        if (fclose(out)) {
+            perror(out_path);
+            ret = 1;
+        }
+    } else if (out) {
+        fflush(stdout);
+    }
+
+    if (nframes) {
+        qsort(frame_ns, nframes, sizeof(*frame_ns), compare_u64);
+
+        double sum = 0;
+        for (uint32_t f = 0; f < nframes; f++)
+            sum += frame_ns[f];
+
+        fprintf(stderr, "replay: %u frames, %d events, frame mean %.3f ms, p50 %.3f ms, p99 %.3f ms, "
+                "max %.3f ms, hash %016llx\n", nframes, nevents, sum / nframes / 1e6,
+                frame_ns[nframes / 2] / 1e6, frame_ns[(uint64_t)nframes * 99 / 100] / 1e6,
+                frame_ns[nframes - 1] / 1e6, (unsigned long long)run_hash);
+    } else {
+        fprintf(stderr, "replay: %s has no frames\n", path);
+    }
+
+    free(frame_ns);
+    free(pixels);
+    free(events);
+
+    return ret;
+}
@@ -0,0 +1,40 @@
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+/*
+ * Input recording and deterministic replay. While recording, every mouse
+ * event the main loop hands to the widgets is logged with the index of the
+ * frame it arrived in, and the frame count is appended on exit. A replay
+ * runs headless from the menu: each frame feeds the events recorded for it,
+ * advances the sim by exactly CONFIG_SIM_HZ/CONFIG_FPS steps inline, renders
+ * and reads back the frame, and hashes its pixels (FNV-1a). Identical builds
+ * give identical hashes, so a replay doubles as a correctness check and as
+ * a repeatable performance trace.
+ *
+ * File layout, little endian: "WREC", u32 version, u32 sim rate, u32 frame
+ * rate, then records of u32 frame, u8 type, u8 button, i16 x, i16 y. The
+ * last record is REPLAY_END with the number of frames recorded.
+ */
+
+#define REPLAY_VERSION 1
+
+typedef enum ReplayType {
+    REPLAY_DOWN,
+    REPLAY_UP,
+    REPLAY_MOTION,
+    REPLAY_END,
+} ReplayType;
+
+bool replay_record_start(const char *path);
+void replay_record_frame(void); // at the start of every main loop iteration
+void replay_record_event(const SDL_Event *ev);
+void replay_record_stop(void);
+
+// writes frame, sim ns, render ns and hash per frame as CSV to out, if given
+int replay_run(const char *path, const char *out);
+
+#endif /* _REPLAY_H */
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+
+void ring_init(Ring *ring, size_t elem_size, unsigned cap)
+{
+    unsigned pow2 = 1;
+    while (pow2 < cap)
+        pow2 *= 2;
+
+    ring->buf = malloc(elem_size * pow2);
+    if (!ring->buf) {
+        fprintf(stderr, "ring: out of memory\n");
+        exit(1);
+    }
+
+    ring->elem_size = elem_size;
+    ring->cap = pow2;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+bool ring_push(Ring *ring, const void *elem)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail == ring->cap)
+        return false;
+
+    memcpy(ring->buf + (head & (ring->cap-1)) * ring->elem_size, elem, ring->elem_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+bool ring_pop(Ring *ring, void *elem)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail)
+        return false;
+
+    memcpy(elem, ring->buf + (tail & (ring->cap-1)) * ring->elem_size, ring->elem_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+unsigned ring_count(Ring *ring)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return head - tail;
+}
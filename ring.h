@@ -0,0 +1,27 @@
+#ifndef _RING_H
+#define _RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ * Lock-free single-producer/single-consumer queue of fixed size elements.
+ * Storage is allocated once in ring_init(), push/pop never block or allocate.
+ */
+typedef struct Ring {
+    unsigned char *buf;
+    size_t elem_size;
+    unsigned cap; // power of two
+
+    atomic_uint head; // next slot to write, owned by the producer
+    atomic_uint tail; // next slot to read, owned by the consumer
+} Ring;
+
+void ring_init(Ring *ring, size_t elem_size, unsigned cap);
+bool ring_push(Ring *ring, const void *elem);
+bool ring_pop(Ring *ring, void *elem);
+// elements queued, exact for the consumer
+unsigned ring_count(Ring *ring);
+
+#endif /* _RING_H */
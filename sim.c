@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include <SDL2/SDL.h>
+
+#include "sim.h"
+#include "ring.h"
+#include "config.h"
+#include "prof.h"
+#include "audio.h"
+
+/*
+ * The scenes are stepped at a fixed rate (CONFIG_SIM_HZ) on their own thread.
+ * After every step the selected scene writes a snapshot into a lock-free triple
+ * buffer which the render thread picks up without ever waiting for the sim.
+ * Slider values travel the other way through a single-producer ring.
+ * Builds without threads (plain emscripten) run the same steps from
+ * sim_update() on the main loop.
+ */
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define SIM_THREADED
+#endif
+
+#define SIM_PARAM_RING_SIZE 256
+
+// set in SnapBuffer.middle when it holds a snapshot the reader has not seen yet
+#define SNAP_FRESH 4
+#define SNAP_INDEX 3
+
+typedef struct SnapBuffer {
+    void *slots[3];
+    int back;           // owned by the sim
+    int front;          // owned by the renderer
+    atomic_int middle;
+} SnapBuffer;
+
+typedef enum SimParamType {
+    PARAM_INT,
+    PARAM_DOUBLE,
+} SimParamType;
+
+typedef struct SimParam {
+    SimParamType type;
+    void *var;
+    double value;
+} SimParam;
+
+static SnapBuffer buffers[SCENE_END];
+static Ring params;
+
+static _Atomic(Scene *) selected_scene = &SCENES[SCENE_MENU];
+static atomic_bool running = false;
+
+#ifdef SIM_THREADED
+static SDL_Thread *thread;
+#endif
+
+static Uint64 next_tick;
+
+static SnapBuffer *scene_buffer(Scene *scene)
+{
+    return &buffers[scene - SCENES];
+}
+
+static void snap_publish(SnapBuffer *buf)
+{
+    buf->back = atomic_exchange_explicit(&buf->middle, buf->back | SNAP_FRESH,
+                                         memory_order_acq_rel) & SNAP_INDEX;
+}
+
+const void *sim_snapshot(Scene *scene)
+{
+    SnapBuffer *buf = scene_buffer(scene);
+
+    if (atomic_load_explicit(&buf->middle, memory_order_acquire) & SNAP_FRESH)
+        buf->front = atomic_exchange_explicit(&buf->middle, buf->front,
+                                              memory_order_acq_rel) & SNAP_INDEX;
+
+    return buf->slots[buf->front];
+}
+
+void sim_init(void)
+{
+    ring_init(&params, sizeof(SimParam), SIM_PARAM_RING_SIZE);
+
+    for (int i = 0; i < SCENE_END; i++) {
+        Scene *scene = &SCENES[i];
+        SnapBuffer *buf = &buffers[i];
+
+        for (int s = 0; s < 3; s++) {
+            buf->slots[s] = calloc(1, scene->snap_size ? scene->snap_size : 1);
+            if (!buf->slots[s]) {
+                fprintf(stderr, "sim: out of memory\n");
+                exit(1);
+            }
+
+            if (scene->snapfn)
+                scene->snapfn(buf->slots[s]);
+        }
+
+        buf->back = 0;
+        atomic_init(&buf->middle, 1);
+        buf->front = 2;
+    }
+}
+
+static void sim_apply_params(void)
+{
+    SimParam param;
+
+    while (ring_pop(&params, &param)) {
+        switch (param.type) {
+        case PARAM_INT:
+            *(int *)param.var = (int)param.value;
+            break;
+        case PARAM_DOUBLE:
+            *(double *)param.var = param.value;
+            break;
+        }
+    }
+}
+
+static void sim_param_push(SimParamType type, void *var, double value)
+{
+    SimParam param = { .type = type, .var = var, .value = value };
+
+    // the sim drains the ring every tick, a full ring only waits for that
+    while (!ring_push(&params, &param)) {
+#ifdef SIM_THREADED
+        SDL_Delay(1);
+#else
+        sim_apply_params();
+#endif
+    }
+}
+
+void sim_param_set_int(int *var, int value)
+{
+    sim_param_push(PARAM_INT, var, value);
+}
+
+void sim_param_set_double(double *var, double value)
+{
+    sim_param_push(PARAM_DOUBLE, var, value);
+}
+
+void sim_select_scene(Scene *scene)
+{
+    atomic_store(&selected_scene, scene);
+}
+
+void sim_tick(void)
+{
+    PROF_BEGIN(PROF_SIM);
+
+    Scene *scene = atomic_load(&selected_scene);
+
+    sim_apply_params();
+
+    if (scene->simfn)
+        scene->simfn();
+    audio_tick();
+
+    if (scene->snapfn) {
+        SnapBuffer *buf = scene_buffer(scene);
+        scene->snapfn(buf->slots[buf->back]);
+        snap_publish(buf);
+    }
+
+    PROF_END(PROF_SIM);
+}
+
+/* Runs the ticks that are due, returns the performance counter of the next one. */
+static Uint64 sim_catch_up(void)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 tick = SDL_GetPerformanceFrequency() / CONFIG_SIM_HZ;
+
+    for (int i = 0; i < CONFIG_SIM_MAX_CATCHUP && now >= next_tick; i++) {
+        sim_tick();
+        next_tick += tick;
+    }
+
+    // too far behind, drop the backlog instead of spiraling
+    if (now >= next_tick)
+        next_tick = now + tick;
+
+    return next_tick;
+}
+
+#ifdef SIM_THREADED
+static int sim_thread(void *data)
+{
+    Uint64 freq = SDL_GetPerformanceFrequency();
+
+    while (atomic_load(&running)) {
+        Uint64 next = sim_catch_up();
+        Uint64 now = SDL_GetPerformanceCounter();
+
+        if (next > now)
+            SDL_Delay((next - now) * 1000 / freq);
+    }
+
+    return 0;
+}
+#endif
+
+void sim_start(void)
+{
+    next_tick = SDL_GetPerformanceCounter();
+    atomic_store(&running, true);
+
+#ifdef SIM_THREADED
+    thread = SDL_CreateThread(sim_thread, "sim", NULL);
+    if (!thread) {
+        fprintf(stderr, "sdl error: CreateThread: %s", SDL_GetError());
+        exit(1);
+    }
+#endif
+}
+
+void sim_stop(void)
+{
+    atomic_store(&running, false);
+
+#ifdef SIM_THREADED
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+#endif
+}
+
+void sim_update(void)
+{
+#ifndef SIM_THREADED
+    if (atomic_load(&running))
+        sim_catch_up();
+#endif
+}
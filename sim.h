@@ -0,0 +1,18 @@
+#ifndef _SIM_H
+#define _SIM_H
+
+#include "draw.h"
+
+void sim_init(void);
+void sim_start(void);
+void sim_stop(void);
+void sim_update(void);
+void sim_tick(void);
+
+void sim_select_scene(Scene *scene);
+const void *sim_snapshot(Scene *scene);
+
+void sim_param_set_int(int *var, int value);
+void sim_param_set_double(double *var, double value);
+
+#endif /* _SIM_H */
@@ -0,0 +1,551 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#include "softrast.h"
+#include "pool.h"
+#include "utils.h"
+#include "config.h"
+
+extern SDL_Renderer *renderer;
+
+#define SR_W CONFIG_WINDOW_WIDTH
+#define SR_H CONFIG_WINDOW_HEIGHT
+
+// rows per band, small enough to keep every thread busy on short flushes
+#define SR_BAND_ROWS 32
+
+// point buckets of SR_BAND_ROWS rows each
+#define SR_BUCKETS ((SR_H + SR_BAND_ROWS - 1) / SR_BAND_ROWS)
+
+typedef enum SoftPrimType {
+    SP_POLYLINE,
+    SP_BOX,
+    SP_CIRCLE,
+    SP_FILLED_CIRCLE,
+    SP_POINTS,
+} SoftPrimType;
+
+typedef struct SoftPrim {
+    SoftPrimType type;
+    Uint8 r, g, b, a;
+    int row0, row1; // rows touched, inclusive
+
+    union {
+        // SP_POLYLINE
+        struct {
+            const SDL_FPoint *pts;
+            int n;
+        };
+        // SP_POINTS, range in sorted[] and its bucket starts in buckets[]
+        struct {
+            int first, count, bucket;
+        };
+        // SP_BOX corners, SP_CIRCLE and SP_FILLED_CIRCLE (x1, y1 = center, x2 = radius)
+        struct {
+            float x1, y1, x2, y2;
+        };
+    };
+} SoftPrim;
+
+static SoftPrim *prims;
+static int nprims, prims_cap;
+
+// points sorted into row buckets, so a band only visits the points that can touch it
+static SDL_FPoint *sorted;
+static int nsorted, sorted_cap;
+static int *buckets;
+static int nbuckets, buckets_cap;
+// bucket of every point of the batch being queued
+static int *point_bucket;
+static int point_bucket_cap;
+
+// dirty rectangle of the queued primitives, [x0, x1) x [y0, y1)
+static int dirty_x0 = SR_W, dirty_y0 = SR_H, dirty_x1 = 0, dirty_y1 = 0;
+
+// premultiplied ARGB, all zero outside of a flush
+static Uint32 *fb;
+// columns written per row, [x0, x1), empty when x0 >= x1
+static int span_x0[SR_H], span_x1[SR_H];
+static SDL_Texture *texture;
+static Uint32 unpremul[256];
+
+static void *grow(void *buf, int *cap, int need, size_t elem)
+{
+    if (need <= *cap)
+        return buf;
+
+    int new_cap = *cap ? *cap : 256;
+    while (new_cap < need)
+        new_cap *= 2;
+
+    buf = realloc(buf, elem * new_cap);
+    if (!buf) {
+        fprintf(stderr, "softrast: out of memory\n");
+        exit(1);
+    }
+
+    *cap = new_cap;
+    return buf;
+}
+
+static SoftPrim *push_prim(SoftPrimType type, SDL_Color c,
+                           float x0, float y0, float x1, float y1)
+{
+    prims = grow(prims, &prims_cap, nprims + 1, sizeof(*prims));
+
+    // one pixel of margin for the anti-aliased edges
+    int ix0 = clamp_int((int)floorf(x0) - 1, 0, SR_W);
+    int iy0 = clamp_int((int)floorf(y0) - 1, 0, SR_H);
+    int ix1 = clamp_int((int)ceilf(x1) + 2, 0, SR_W);
+    int iy1 = clamp_int((int)ceilf(y1) + 2, 0, SR_H);
+
+    SoftPrim *p = &prims[nprims];
+    p->type = type;
+    p->r = c.r; p->g = c.g; p->b = c.b; p->a = c.a;
+    p->row0 = iy0;
+    p->row1 = iy1 - 1;
+
+    // entirely off screen, keep the slot unused
+    if (ix0 >= ix1 || iy0 >= iy1 || !c.a)
+        return p;
+
+    if (ix0 < dirty_x0) dirty_x0 = ix0;
+    if (iy0 < dirty_y0) dirty_y0 = iy0;
+    if (ix1 > dirty_x1) dirty_x1 = ix1;
+    if (iy1 > dirty_y1) dirty_y1 = iy1;
+
+    nprims++;
+    return p;
+}
+
+void softrast_polyline(const SDL_FPoint *pts, int n, SDL_Color color)
+{
+    if (n < 2)
+        return;
+
+    float x0 = pts[0].x, y0 = pts[0].y, x1 = x0, y1 = y0;
+    for (int i = 1; i < n; i++) {
+        x0 = fminf(x0, pts[i].x); x1 = fmaxf(x1, pts[i].x);
+        y0 = fminf(y0, pts[i].y); y1 = fmaxf(y1, pts[i].y);
+    }
+
+    SoftPrim *p = push_prim(SP_POLYLINE, color, x0, y0, x1, y1);
+    p->pts = pts;
+    p->n = n;
+}
+
+void softrast_points(const SDL_FPoint *pts, int n, SDL_Color color)
+{
+    if (n < 1)
+        return;
+
+    // counting sort by row, clamped to the screen, in the same pass as the bounds
+    static int cursor[SR_BUCKETS];
+    memset(cursor, 0, sizeof(cursor));
+    point_bucket = grow(point_bucket, &point_bucket_cap, n, sizeof(*point_bucket));
+
+    float x0 = pts[0].x, y0 = pts[0].y, x1 = x0, y1 = y0;
+    for (int i = 0; i < n; i++) {
+        SDL_FPoint pt = pts[i];
+        x0 = pt.x < x0 ? pt.x : x0; x1 = pt.x > x1 ? pt.x : x1;
+        y0 = pt.y < y0 ? pt.y : y0; y1 = pt.y > y1 ? pt.y : y1;
+
+        int b = clamp_int((int)floorf(pt.y), 0, SR_H - 1) / SR_BAND_ROWS;
+        point_bucket[i] = b;
+        cursor[b]++;
+    }
+
+    SoftPrim *p = push_prim(SP_POINTS, color, x0, y0, x1, y1);
+    if (p == &prims[nprims]) // off screen
+        return;
+
+    buckets = grow(buckets, &buckets_cap, nbuckets + SR_BUCKETS + 1, sizeof(*buckets));
+    int *start = &buckets[nbuckets];
+    start[0] = 0;
+    for (int b = 0; b < SR_BUCKETS; b++) {
+        start[b + 1] = start[b] + cursor[b];
+        cursor[b] = start[b];
+    }
+
+    sorted = grow(sorted, &sorted_cap, nsorted + n, sizeof(*sorted));
+    SDL_FPoint *out = &sorted[nsorted];
+    for (int i = 0; i < n; i++)
+        out[cursor[point_bucket[i]]++] = pts[i];
+
+    p->first = nsorted;
+    p->count = n;
+    p->bucket = nbuckets;
+    nsorted += n;
+    nbuckets += SR_BUCKETS + 1;
+}
+
+void softrast_box(float x1, float y1, float x2, float y2, SDL_Color color)
+{
+    SoftPrim *p = push_prim(SP_BOX, color, x1, y1, x2 + 1, y2 + 1);
+    p->x1 = x1; p->y1 = y1;
+    p->x2 = x2; p->y2 = y2;
+}
+
+void softrast_circle(float x, float y, float rad, SDL_Color color)
+{
+    SoftPrim *p = push_prim(SP_CIRCLE, color, x - rad - 1, y - rad - 1, x + rad + 1, y + rad + 1);
+    p->x1 = x; p->y1 = y;
+    p->x2 = rad;
+}
+
+void softrast_filled_circle(float x, float y, float rad, SDL_Color color)
+{
+    SoftPrim *p = push_prim(SP_FILLED_CIRCLE, color, x - rad - 1, y - rad - 1, x + rad + 1, y + rad + 1);
+    p->x1 = x; p->y1 = y;
+    p->x2 = rad;
+}
+
+static inline Uint32 div255(Uint32 x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+typedef struct Band {
+    int y0, y1; // rows, [y0, y1)
+} Band;
+
+/* Source over for one pixel, cov in [0, 1] scales the primitive's alpha. */
+static inline void plot(const SoftPrim *p, const Band *band, int x, int y, float cov)
+{
+    if (x < 0 || x >= SR_W || y < band->y0 || y >= band->y1 || cov <= 0)
+        return;
+
+    Uint32 alpha = (Uint32)(p->a * fminf(cov, 1.f) + 0.5f);
+    if (!alpha)
+        return;
+
+    if (x < span_x0[y])
+        span_x0[y] = x;
+    if (x >= span_x1[y])
+        span_x1[y] = x + 1;
+
+    Uint32 *px = &fb[y * SR_W + x];
+    Uint32 d = *px, inv = 255 - alpha;
+
+    Uint32 a = alpha + div255((d >> 24) * inv);
+    Uint32 r = div255(p->r * alpha) + div255((d >> 16 & 0xff) * inv);
+    Uint32 g = div255(p->g * alpha) + div255((d >> 8 & 0xff) * inv);
+    Uint32 b = div255(p->b * alpha) + div255((d & 0xff) * inv);
+
+    *px = a << 24 | r << 16 | g << 8 | b;
+}
+
+/*
+ * Wu line from p to q along its major axis, the pixel at q is left out
+ * unless last is set so joints of a polyline are not blended twice.
+ */
+static void raster_segment(const SoftPrim *prim, const Band *band,
+                           SDL_FPoint p, SDL_FPoint q, bool last)
+{
+    float dx = q.x - p.x, dy = q.y - p.y;
+
+    if (fabsf(dx) >= fabsf(dy)) {
+        if (dx == 0) {
+            if (last)
+                plot(prim, band, (int)lroundf(p.x), (int)lroundf(p.y), 1);
+            return;
+        }
+
+        float grad = dy / dx;
+        int xa = (int)lroundf(p.x), xb = (int)lroundf(q.x);
+        int lo = xa < xb ? xa : xb, hi = xa < xb ? xb : xa;
+        if (!last) {
+            if (xb > xa) hi--;
+            else lo++;
+        }
+
+        // columns whose rows can reach the band
+        if (grad != 0) {
+            float xt = p.x + (band->y0 - 1 - p.y) / grad;
+            float xu = p.x + (band->y1 - p.y) / grad;
+            lo = SDL_max(lo, (int)floorf(fminf(xt, xu)));
+            hi = SDL_min(hi, (int)ceilf(fmaxf(xt, xu)));
+        }
+        lo = SDL_max(lo, 0);
+        hi = SDL_min(hi, SR_W - 1);
+
+        for (int x = lo; x <= hi; x++) {
+            float y = p.y + grad * (x - p.x);
+            float yf = floorf(y), f = y - yf;
+            plot(prim, band, x, (int)yf, 1 - f);
+            plot(prim, band, x, (int)yf + 1, f);
+        }
+    } else {
+        float grad = dx / dy;
+        int ya = (int)lroundf(p.y), yb = (int)lroundf(q.y);
+        int lo = ya < yb ? ya : yb, hi = ya < yb ? yb : ya;
+        if (!last) {
+            if (yb > ya) hi--;
+            else lo++;
+        }
+
+        lo = SDL_max(lo, band->y0);
+        hi = SDL_min(hi, band->y1 - 1);
+
+        for (int y = lo; y <= hi; y++) {
+            float x = p.x + grad * (y - p.y);
+            float xf = floorf(x), f = x - xf;
+            plot(prim, band, (int)xf, y, 1 - f);
+            plot(prim, band, (int)xf + 1, y, f);
+        }
+    }
+}
+
+static void raster_polyline(const SoftPrim *p, const Band *band)
+{
+    for (int i = 0; i < p->n - 1; i++) {
+        SDL_FPoint a = p->pts[i], b = p->pts[i+1];
+        if (fmaxf(a.y, b.y) + 1 < band->y0 || fminf(a.y, b.y) - 1 >= band->y1)
+            continue;
+
+        raster_segment(p, band, a, b, i == p->n - 2);
+    }
+}
+
+/*
+ * Points fill the pixel they fall in, like SDL_RenderDrawPointsF. Splitting
+ * them over four pixels would leave a dense batch translucent everywhere and
+ * cost the unpremultiply on every pixel of the flush.
+ */
+static void raster_points(const SoftPrim *p, const Band *band)
+{
+    const int *start = &buckets[p->bucket];
+    int b0 = band->y0 / SR_BAND_ROWS;
+    int b1 = (band->y1 - 1) / SR_BAND_ROWS;
+
+    // opaque points overwrite the pixel, the common case of a dense batch
+    if (p->a == 255) {
+        Uint32 c = 0xffu << 24 | p->r << 16 | p->g << 8 | p->b;
+
+        for (int i = start[b0]; i < start[b1 + 1]; i++) {
+            SDL_FPoint pt = sorted[p->first + i];
+            int x = (int)floorf(pt.x), y = (int)floorf(pt.y);
+            if (x < 0 || x >= SR_W || y < band->y0 || y >= band->y1)
+                continue;
+
+            if (x < span_x0[y])
+                span_x0[y] = x;
+            if (x >= span_x1[y])
+                span_x1[y] = x + 1;
+            fb[y * SR_W + x] = c;
+        }
+        return;
+    }
+
+    for (int i = start[b0]; i < start[b1 + 1]; i++) {
+        SDL_FPoint pt = sorted[p->first + i];
+        plot(p, band, (int)floorf(pt.x), (int)floorf(pt.y), 1);
+    }
+}
+
+// length of [a, b) inside the pixel [i, i + 1)
+static inline float span_cover(float a, float b, int i)
+{
+    return fmaxf(0, fminf(b, i + 1) - fmaxf(a, i));
+}
+
+static void raster_box(const SoftPrim *p, const Band *band)
+{
+    // same extent as the triangulated box, [x1, x2 + 1) x [y1, y2 + 1)
+    float x1 = p->x1, x2 = p->x2 + 1, y1 = p->y1, y2 = p->y2 + 1;
+
+    int col0 = SDL_max((int)floorf(x1), 0), col1 = SDL_min((int)ceilf(x2), SR_W);
+    int row0 = SDL_max((int)floorf(y1), band->y0), row1 = SDL_min((int)ceilf(y2), band->y1);
+
+    for (int y = row0; y < row1; y++) {
+        float cy = span_cover(y1, y2, y);
+        for (int x = col0; x < col1; x++)
+            plot(p, band, x, y, cy * span_cover(x1, x2, x));
+    }
+}
+
+static void raster_circle(const SoftPrim *p, const Band *band)
+{
+    float cx = p->x1, cy = p->y1, rad = p->x2;
+    float r_out = rad + 1, r_in = rad - 1;
+
+    int row0 = SDL_max((int)ceilf(cy - r_out), band->y0);
+    int row1 = SDL_min((int)floorf(cy + r_out), band->y1 - 1);
+
+    for (int y = row0; y <= row1; y++) {
+        float dy = y - cy;
+        float xo = sqrtf(fmaxf(0, r_out*r_out - dy*dy));
+        float xi = r_in > 0 && r_in*r_in > dy*dy ? sqrtf(r_in*r_in - dy*dy) : -1;
+
+        // left and right arcs of the ring, one span when the row misses the hole
+        int spans[2][2] = {
+            { (int)ceilf(cx - xo), xi < 0 ? (int)floorf(cx + xo) : (int)floorf(cx - xi) },
+            { (int)ceilf(cx + xi), (int)floorf(cx + xo) },
+        };
+
+        for (int s = 0; s < (xi < 0 ? 1 : 2); s++) {
+            int lo = SDL_max(spans[s][0], 0), hi = SDL_min(spans[s][1], SR_W - 1);
+            for (int x = lo; x <= hi; x++) {
+                float dx = x - cx;
+                plot(p, band, x, y, 1 - fabsf(sqrtf(dx*dx + dy*dy) - rad));
+            }
+        }
+    }
+}
+
+static void raster_filled_circle(const SoftPrim *p, const Band *band)
+{
+    float cx = p->x1, cy = p->y1, rad = p->x2;
+    float r_out = rad + 0.5f, r_in = rad - 0.5f;
+
+    int row0 = SDL_max((int)ceilf(cy - r_out), band->y0);
+    int row1 = SDL_min((int)floorf(cy + r_out), band->y1 - 1);
+
+    for (int y = row0; y <= row1; y++) {
+        float dy = y - cy;
+        float xo = sqrtf(fmaxf(0, r_out*r_out - dy*dy));
+        float xi = r_in > 0 && r_in*r_in > dy*dy ? sqrtf(r_in*r_in - dy*dy) : -1;
+
+        int lo = SDL_max((int)ceilf(cx - xo), 0), hi = SDL_min((int)floorf(cx + xo), SR_W - 1);
+        for (int x = lo; x <= hi; x++) {
+            float dx = x - cx;
+            // fully covered inside the inner radius
+            float cov = fabsf(dx) <= xi ? 1 : r_out - sqrtf(dx*dx + dy*dy);
+            plot(p, band, x, y, cov);
+        }
+    }
+}
+
+typedef struct FlushCtx {
+    int nbands;
+    Uint8 *pixels; // locked texture, origin at the dirty rectangle
+    int pitch;
+} FlushCtx;
+
+static void flush_band(void *data, int task)
+{
+    FlushCtx *ctx = data;
+
+    int rows = dirty_y1 - dirty_y0;
+    Band band = {
+        dirty_y0 + rows * task / ctx->nbands,
+        dirty_y0 + rows * (task + 1) / ctx->nbands,
+    };
+
+    for (int i = 0; i < nprims; i++) {
+        const SoftPrim *p = &prims[i];
+        if (p->row1 < band.y0 || p->row0 >= band.y1)
+            continue;
+
+        switch (p->type) {
+        case SP_POLYLINE:
+            raster_polyline(p, &band);
+            break;
+        case SP_BOX:
+            raster_box(p, &band);
+            break;
+        case SP_CIRCLE:
+            raster_circle(p, &band);
+            break;
+        case SP_FILLED_CIRCLE:
+            raster_filled_circle(p, &band);
+            break;
+        case SP_POINTS:
+            raster_points(p, &band);
+            break;
+        }
+    }
+
+    // the texture wants straight alpha, the framebuffer is left cleared
+    for (int y = band.y0; y < band.y1; y++) {
+        // both rows start at the dirty rectangle's left edge
+        Uint32 *dst = (Uint32 *)(ctx->pixels + (size_t)(y - dirty_y0) * ctx->pitch);
+        Uint32 *src = &fb[y * SR_W + dirty_x0];
+        int w = dirty_x1 - dirty_x0;
+        int x0 = SDL_max(span_x0[y] - dirty_x0, 0), x1 = SDL_min(span_x1[y] - dirty_x0, w);
+
+        if (x0 >= x1) {
+            memset(dst, 0, sizeof(*dst) * w);
+            continue;
+        }
+
+        memset(dst, 0, sizeof(*dst) * x0);
+        memset(dst + x1, 0, sizeof(*dst) * (w - x1));
+
+        for (int x = x0; x < x1; x++) {
+            Uint32 c = src[x], a = c >> 24;
+            if (a == 0 || a == 255) {
+                dst[x] = c;
+                continue;
+            }
+
+            Uint32 k = unpremul[a];
+            Uint32 r = SDL_min(((c >> 16 & 0xff) * k + 32768) >> 16, 255);
+            Uint32 g = SDL_min(((c >> 8 & 0xff) * k + 32768) >> 16, 255);
+            Uint32 b = SDL_min(((c & 0xff) * k + 32768) >> 16, 255);
+            dst[x] = a << 24 | r << 16 | g << 8 | b;
+        }
+
+        memset(src + x0, 0, sizeof(*src) * (x1 - x0));
+        span_x0[y] = SR_W;
+        span_x1[y] = 0;
+    }
+}
+
+static void softrast_init(void)
+{
+    fb = calloc((size_t)SR_W * SR_H, sizeof(*fb));
+    if (!fb) {
+        fprintf(stderr, "softrast: out of memory\n");
+        exit(1);
+    }
+
+    for (int y = 0; y < SR_H; y++)
+        span_x0[y] = SR_W;
+
+    for (int a = 1; a < 256; a++)
+        unpremul[a] = (255u * 65536 + a/2) / a;
+
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                SR_W, SR_H);
+    if (!texture) {
+        fprintf(stderr, "sdl error: CreateTexture: %s\n", SDL_GetError());
+        exit(1);
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+}
+
+void softrast_flush(void)
+{
+    if (nprims) {
+        if (!fb)
+            softrast_init();
+
+        SDL_Rect rect = { dirty_x0, dirty_y0, dirty_x1 - dirty_x0, dirty_y1 - dirty_y0 };
+
+        FlushCtx ctx;
+        void *pixels;
+        if (SDL_LockTexture(texture, &rect, &pixels, &ctx.pitch)) {
+            fprintf(stderr, "sdl error: LockTexture: %s\n", SDL_GetError());
+            exit(1);
+        }
+        ctx.pixels = pixels;
+        ctx.nbands = (rect.h + SR_BAND_ROWS - 1) / SR_BAND_ROWS;
+
+        pool_run(flush_band, &ctx, ctx.nbands);
+
+        SDL_UnlockTexture(texture);
+        SDL_RenderCopy(renderer, texture, &rect, &rect);
+    }
+
+    nprims = 0;
+    nsorted = nbuckets = 0;
+    dirty_x0 = SR_W; dirty_y0 = SR_H;
+    dirty_x1 = 0; dirty_y1 = 0;
+}
@@ -0,0 +1,27 @@
+#ifndef _SOFTRAST_H
+#define _SOFTRAST_H
+
+#include <SDL2/SDL.h>
+
+/*
+ * CPU rasterizer behind the drawlist's soft backend. Primitives queued
+ * between two softrast_flush() calls are drawn in order with coverage based
+ * anti-aliasing (Wu lines, analytic circle and box edges) into a
+ * premultiplied framebuffer. The flush splits the touched rows into bands
+ * for the worker pool, each band is rasterized, converted into a locked
+ * streaming texture and cleared again, and the texture is copied onto the
+ * current render target once. Lines are always one pixel wide, points fill
+ * one pixel without anti-aliasing. Polyline points are not copied and must
+ * stay valid until the flush, point batches are copied and sorted into row
+ * buckets.
+ */
+
+void softrast_polyline(const SDL_FPoint *pts, int n, SDL_Color color);
+void softrast_points(const SDL_FPoint *pts, int n, SDL_Color color);
+void softrast_box(float x1, float y1, float x2, float y2, SDL_Color color);
+void softrast_circle(float x, float y, float rad, SDL_Color color);
+void softrast_filled_circle(float x, float y, float rad, SDL_Color color);
+
+void softrast_flush(void);
+
+#endif /* _SOFTRAST_H */
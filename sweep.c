@@ -0,0 +1,450 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <math.h>
+
+#include <SDL2/SDL.h>
+
+#include "sweep.h"
+#include "pool.h"
+#include "draw.h"
+#include "doppler.h"
+#include "config.h"
+
+#define SWEEP_MAX_PARAMS 4
+#define SWEEP_MAX_OUTPUTS 4
+#define SWEEP_MAX_COLS (SWEEP_MAX_PARAMS + SWEEP_MAX_OUTPUTS)
+
+typedef struct SweepModel {
+    const char *name;
+
+    int nparams;
+    const char *params[SWEEP_MAX_PARAMS];
+    double defaults[SWEEP_MAX_PARAMS];
+
+    int noutputs;
+    const char *outputs[SWEEP_MAX_OUTPUTS];
+
+    void (*eval)(const double *in, double *out);
+} SweepModel;
+
+static void eval_doppler(const double *in, double *out)
+{
+    if (in[1] <= 0) {
+        out[0] = out[1] = NAN;
+        return;
+    }
+
+    doppler_observe(in[0], in[1], &out[0], &out[1]);
+}
+
+static void eval_interference(const double *in, double *out)
+{
+    interference_measure(in[0], in[1], in[2], &out[0], &out[1]);
+}
+
+static const SweepModel MODELS[] = {
+    {
+        .name = "doppler",
+        .nparams = 2,
+        .params = { "v", "c" },
+        .defaults = { DEFAULT_DOPPLER_V, DEFAULT_DOPPLER_WAVE_SPEED },
+        .noutputs = 2,
+        .outputs = { "approach", "recede" },
+        .eval = eval_doppler,
+    },
+    {
+        .name = "interference",
+        .nparams = 3,
+        .params = { "phi", "lambda", "amplitude" },
+        .defaults = { DEFAULT_GLOB_PHI, DEFAULT_GLOB_LAMBDA, DEFAULT_GLOB_AMPLITUDE },
+        .noutputs = 2,
+        .outputs = { "peak", "rms" },
+        .eval = eval_interference,
+    },
+};
+
+#define SWEEP_MODELS (int)(sizeof(MODELS) / sizeof(MODELS[0]))
+
+typedef struct SweepAxis {
+    double start, stop;
+    uint64_t count;
+} SweepAxis;
+
+// begin << 32 | end of the points of a batch left to its owner, padded to a cache line
+typedef struct SweepRange {
+    _Alignas(64) _Atomic uint64_t range;
+} SweepRange;
+
+typedef struct SweepState {
+    const SweepModel *model;
+    SweepAxis axes[SWEEP_MAX_PARAMS];
+    int ncols;
+    uint64_t points;
+
+    // batch in progress
+    uint64_t first;
+    int count;
+    double *rows;
+    int nranges;
+    SweepRange *ranges;
+    atomic_ullong steals;
+
+    // writer side
+    FILE *out;
+    bool binary;
+    double *buffers[SWEEP_BUFFERS];
+    int buffer_rows[SWEEP_BUFFERS];
+    int nbatches;
+    SDL_sem *free_bufs;
+    SDL_sem *full_bufs;
+    bool failed;
+} SweepState;
+
+static bool ends_with(const char *s, const char *suffix)
+{
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && !strcmp(s + n - m, suffix);
+}
+
+static const SweepModel *find_model(const char *name)
+{
+    for (int i = 0; i < SWEEP_MODELS; i++)
+        if (!strcmp(MODELS[i].name, name))
+            return &MODELS[i];
+
+    return NULL;
+}
+
+static bool parse_axis(const char *spec, SweepAxis *axis)
+{
+    char *end;
+    long long count;
+
+    axis->start = strtod(spec, &end);
+    if (end == spec)
+        return false;
+    if (*end == '\0') {
+        axis->stop = axis->start;
+        axis->count = 1;
+        return true;
+    }
+
+    if (*end != ':')
+        return false;
+    spec = end + 1;
+    axis->stop = strtod(spec, &end);
+    if (end == spec || *end != ':')
+        return false;
+    spec = end + 1;
+    count = strtoll(spec, &end, 10);
+    if (end == spec || *end != '\0' || count < 1)
+        return false;
+
+    axis->count = count;
+    return true;
+}
+
+static bool parse_grid(SweepState *sw, const char *grid)
+{
+    const SweepModel *m = sw->model;
+
+    for (int i = 0; i < m->nparams; i++)
+        sw->axes[i] = (SweepAxis) { m->defaults[i], m->defaults[i], 1 };
+
+    char *copy = strdup(grid);
+    if (!copy) {
+        fprintf(stderr, "sweep: out of memory\n");
+        exit(1);
+    }
+
+    bool ok = true;
+    for (char *save, *tok = strtok_r(copy, ",", &save); tok && ok; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        if (!eq) {
+            fprintf(stderr, "sweep: expected name=value or name=start:stop:count, got '%s'\n", tok);
+            ok = false;
+            break;
+        }
+        *eq = '\0';
+
+        int p = 0;
+        while (p < m->nparams && strcmp(m->params[p], tok))
+            p++;
+
+        if (p == m->nparams) {
+            fprintf(stderr, "sweep: %s has no parameter '%s'\n", m->name, tok);
+            ok = false;
+        } else if (!parse_axis(eq + 1, &sw->axes[p])) {
+            fprintf(stderr, "sweep: bad range '%s' for %s\n", eq + 1, tok);
+            ok = false;
+        }
+    }
+
+    free(copy);
+    if (!ok)
+        return false;
+
+    sw->points = 1;
+    for (int i = 0; i < m->nparams; i++) {
+        if (sw->axes[i].count > UINT64_MAX / sw->points) {
+            fprintf(stderr, "sweep: grid too large\n");
+            return false;
+        }
+        sw->points *= sw->axes[i].count;
+    }
+
+    return true;
+}
+
+static void eval_point(const SweepState *sw, uint64_t index, double *row)
+{
+    const SweepModel *m = sw->model;
+
+    for (int i = m->nparams - 1; i >= 0; i--) {
+        const SweepAxis *a = &sw->axes[i];
+        uint64_t k = index % a->count;
+        index /= a->count;
+
+        row[i] = a->count > 1 ? a->start + (a->stop - a->start) * k / (a->count - 1) : a->start;
+    }
+
+    m->eval(row, row + m->nparams);
+}
+
+static void eval_range(SweepState *sw, uint32_t begin, uint32_t end)
+{
+    for (uint32_t i = begin; i < end; i++)
+        eval_point(sw, sw->first + i, sw->rows + (size_t)i * sw->ncols);
+}
+
+static inline uint64_t pack(uint32_t begin, uint32_t end)
+{
+    return (uint64_t)begin << 32 | end;
+}
+
+// takes the back half of the largest range left, false when nothing is worth stealing
+static bool steal(SweepState *sw, int self)
+{
+    for (;;) {
+        int victim = -1;
+        uint64_t seen = 0;
+        uint32_t most = SWEEP_CHUNK;
+
+        for (int i = 0; i < sw->nranges; i++) {
+            uint64_t r = atomic_load_explicit(&sw->ranges[i].range, memory_order_relaxed);
+            uint32_t begin = r >> 32, end = (uint32_t)r;
+
+            if (i != self && end > begin && end - begin > most) {
+                victim = i;
+                seen = r;
+                most = end - begin;
+            }
+        }
+
+        if (victim < 0)
+            return false;
+
+        uint32_t begin = seen >> 32, end = (uint32_t)seen;
+        uint32_t mid = begin + (end - begin) / 2;
+
+        if (atomic_compare_exchange_weak(&sw->ranges[victim].range, &seen, pack(begin, mid))) {
+            atomic_store(&sw->ranges[self].range, pack(mid, end));
+            atomic_fetch_add_explicit(&sw->steals, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+static void sweep_task(void *ctx, int task)
+{
+    SweepState *sw = ctx;
+    _Atomic uint64_t *own = &sw->ranges[task].range;
+
+    do {
+        uint64_t r = atomic_load(own);
+        for (;;) {
+            uint32_t begin = r >> 32, end = (uint32_t)r;
+            if (begin >= end)
+                break;
+
+            uint32_t next = end - begin > SWEEP_CHUNK ? begin + SWEEP_CHUNK : end;
+            if (atomic_compare_exchange_weak(own, &r, pack(next, end))) {
+                eval_range(sw, begin, next);
+                r = atomic_load(own);
+            }
+        }
+    } while (steal(sw, task));
+}
+
+static void write_header(SweepState *sw)
+{
+    const SweepModel *m = sw->model;
+    const char *names[SWEEP_MAX_COLS];
+
+    for (int i = 0; i < m->nparams; i++)
+        names[i] = m->params[i];
+    for (int i = 0; i < m->noutputs; i++)
+        names[m->nparams + i] = m->outputs[i];
+
+    if (!sw->binary) {
+        for (int i = 0; i < sw->ncols; i++)
+            fprintf(sw->out, "%s%c", names[i], i + 1 < sw->ncols ? ',' : '\n');
+        return;
+    }
+
+    uint32_t version = SWEEP_BIN_VERSION, ncols = sw->ncols;
+    uint64_t rows = sw->points;
+
+    fwrite("WSWP", 1, 4, sw->out);
+    fwrite(&version, sizeof(version), 1, sw->out);
+    fwrite(&ncols, sizeof(ncols), 1, sw->out);
+    for (int i = 0; i < sw->ncols; i++)
+        fwrite(names[i], 1, strlen(names[i]) + 1, sw->out);
+    fwrite(&rows, sizeof(rows), 1, sw->out);
+}
+
+static bool write_rows(SweepState *sw, const double *rows, int n)
+{
+    if (sw->binary)
+        return fwrite(rows, sizeof(double) * sw->ncols, n, sw->out) == (size_t)n;
+
+    for (int i = 0; i < n; i++) {
+        const double *row = rows + (size_t)i * sw->ncols;
+        for (int c = 0; c < sw->ncols; c++)
+            if (fprintf(sw->out, "%.9g%c", row[c], c + 1 < sw->ncols ? ',' : '\n') < 0)
+                return false;
+    }
+
+    return true;
+}
+
+static int sweep_writer(void *data)
+{
+    SweepState *sw = data;
+
+    write_header(sw);
+
+    for (int b = 0; b < sw->nbatches; b++) {
+        SDL_SemWait(sw->full_bufs);
+
+        int buf = b % SWEEP_BUFFERS;
+        if (!sw->failed && !write_rows(sw, sw->buffers[buf], sw->buffer_rows[buf])) {
+            perror("sweep: write");
+            sw->failed = true;
+        }
+
+        SDL_SemPost(sw->free_bufs);
+    }
+
+    return 0;
+}
+
+static void run_batch(SweepState *sw)
+{
+    // even split to start with, stealing evens out what the split got wrong
+    for (int i = 0; i < sw->nranges; i++) {
+        uint32_t begin = (uint64_t)sw->count * i / sw->nranges;
+        uint32_t end = (uint64_t)sw->count * (i + 1) / sw->nranges;
+        atomic_store(&sw->ranges[i].range, pack(begin, end));
+    }
+
+    pool_run(sweep_task, sw, sw->nranges);
+}
+
+int sweep_run(const char *model_name, const char *grid, const char *path)
+{
+    SweepState sw = { .model = find_model(model_name) };
+
+    if (!sw.model) {
+        fprintf(stderr, "sweep: no model named '%s', one of:", model_name);
+        for (int i = 0; i < SWEEP_MODELS; i++)
+            fprintf(stderr, " %s", MODELS[i].name);
+        fprintf(stderr, "\n");
+        return 1;
+    }
+
+    if (!parse_grid(&sw, grid))
+        return 1;
+
+    sw.ncols = sw.model->nparams + sw.model->noutputs;
+    sw.binary = ends_with(path, ".bin");
+    sw.nbatches = (int)((sw.points + SWEEP_BATCH - 1) / SWEEP_BATCH);
+    if ((uint64_t)sw.nbatches * SWEEP_BATCH < sw.points) {
+        fprintf(stderr, "sweep: grid too large\n");
+        return 1;
+    }
+
+    sw.out = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+    if (!sw.out) {
+        perror(path);
+        return 1;
+    }
+    setvbuf(sw.out, NULL, _IOFBF, 1 << 20);
+
+    sw.nranges = pool_threads();
+    sw.ranges = aligned_alloc(_Alignof(SweepRange), sizeof(SweepRange) * sw.nranges);
+    for (int i = 0; i < SWEEP_BUFFERS; i++)
+        sw.buffers[i] = malloc(sizeof(double) * sw.ncols * SWEEP_BATCH);
+    for (int i = 0; i < SWEEP_BUFFERS; i++) {
+        if (!sw.ranges || !sw.buffers[i]) {
+            fprintf(stderr, "sweep: out of memory\n");
+            exit(1);
+        }
+    }
+
+    sw.free_bufs = SDL_CreateSemaphore(SWEEP_BUFFERS);
+    sw.full_bufs = SDL_CreateSemaphore(0);
+    SDL_Thread *writer = SDL_CreateThread(sweep_writer, "sweep", &sw);
+    if (!sw.free_bufs || !sw.full_bufs || !writer) {
+        fprintf(stderr, "sdl error: sweep: %s\n", SDL_GetError());
+        exit(1);
+    }
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 stalled = 0;
+
+    for (int b = 0; b < sw.nbatches; b++) {
+        Uint64 wait = SDL_GetPerformanceCounter();
+        SDL_SemWait(sw.free_bufs);
+        stalled += SDL_GetPerformanceCounter() - wait;
+
+        int buf = b % SWEEP_BUFFERS;
+        sw.first = (uint64_t)b * SWEEP_BATCH;
+        sw.count = sw.points - sw.first < SWEEP_BATCH ? (int)(sw.points - sw.first) : SWEEP_BATCH;
+        sw.rows = sw.buffers[buf];
+        run_batch(&sw);
+
+        sw.buffer_rows[buf] = sw.count;
+        SDL_SemPost(sw.full_bufs);
+    }
+
+    SDL_WaitThread(writer, NULL);
+    double secs = (double)(SDL_GetPerformanceCounter() - start) / freq;
+
+    if (sw.out != stdout) {
+        if (fclose(sw.out) && !sw.failed) {
+            perror("sweep: close");
+            sw.failed = true;
+        }
+    } else {
+        fflush(stdout);
+    }
+
+    fprintf(stderr, "sweep: %llu points of %s in %.2f s (%.2f Mpoints/s) on %d threads, "
+            "%llu steals, compute stalled %.2f s\n",
+            (unsigned long long)sw.points, sw.model->name, secs, sw.points / secs / 1e6, sw.nranges,
+            (unsigned long long)atomic_load(&sw.steals), (double)stalled / freq);
+
+    SDL_DestroySemaphore(sw.free_bufs);
+    SDL_DestroySemaphore(sw.full_bufs);
+    for (int i = 0; i < SWEEP_BUFFERS; i++)
+        free(sw.buffers[i]);
+    free(sw.ranges);
+
+    return sw.failed;
+}
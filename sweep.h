@@ -0,0 +1,32 @@
+#ifndef _SWEEP_H
+#define _SWEEP_H
+
+/*
+ * Batch mode: evaluates a scene model at every point of a parameter grid
+ * without rendering and streams one row per point (the parameters followed
+ * by the model's outputs) as CSV, or as binary for paths ending in .bin. A
+ * path of "-" writes to stdout.
+ *
+ * The grid is a comma separated list of name=value or name=start:stop:count
+ * (count values from start to stop inclusive), parameters left out keep the
+ * scene's default. Points are the cartesian product in row-major order, the
+ * last parameter varies fastest.
+ *
+ * Points are evaluated in batches of SWEEP_BATCH on the worker pool. Every
+ * thread owns a range of the batch and takes SWEEP_CHUNK points at a time
+ * from its front, a thread that ran out steals the back half of the largest
+ * range left. Finished batches go to a writer thread, which formats them
+ * while the next batch is computed.
+ *
+ * Binary layout, little endian: "WSWP", u32 version, u32 column count, the
+ * NUL terminated column names, u64 row count, then the rows as f64.
+ */
+
+#define SWEEP_BATCH (1 << 18)
+#define SWEEP_CHUNK 256
+#define SWEEP_BUFFERS 2
+#define SWEEP_BIN_VERSION 1
+
+int sweep_run(const char *model_name, const char *grid, const char *path);
+
+#endif /* _SWEEP_H */
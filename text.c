@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "text.h"
+#include "config.h"
+#include "prof.h"
+
+extern SDL_Renderer *renderer;
+extern TTF_Font *font;
+extern TTF_Font *font_small;
+extern TTF_Font *font_huge;
+
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST '~'
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+
+#define ATLAS_WIDTH 1024
+#define ATLAS_PAD 1
+
+typedef struct Glyph {
+    SDL_Rect src;
+    int advance;
+} Glyph;
+
+/*
+ * Every printable ascii glyph of one font is rasterized once into a single
+ * texture. render_text() only appends quads to the atlas' vertex buffer,
+ * text_flush() then submits each atlas with one SDL_RenderGeometry call.
+ */
+typedef struct Atlas {
+    TTF_Font *font;
+    SDL_Texture *texture;
+    int tex_w, tex_h;
+    int height;
+    Glyph glyphs[GLYPH_COUNT];
+
+    SDL_Vertex *verts;
+    int *indices;
+    int nquads, cap;
+} Atlas;
+
+static Atlas atlases[3];
+static int atlas_count = 0;
+
+static void panic_ttf(const char *msg)
+{
+    fprintf(stderr, "sdl_ttf error: %s: %s", msg, TTF_GetError());
+    exit(1);
+}
+
+static void atlas_build(Atlas *atlas, TTF_Font *atlas_font)
+{
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *rendered[GLYPH_COUNT];
+
+    atlas->font = atlas_font;
+    atlas->height = TTF_FontHeight(atlas_font);
+
+    // shelf-pack the glyphs into rows of ATLAS_WIDTH
+    int pen_x = 0, pen_y = 0;
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        rendered[i] = TTF_RenderGlyph_Blended(atlas_font, GLYPH_FIRST + i, white);
+        if (!rendered[i])
+            panic_ttf("TTF_RenderGlyph_Blended");
+
+        if (TTF_GlyphMetrics(atlas_font, GLYPH_FIRST + i,
+                             NULL, NULL, NULL, NULL, &atlas->glyphs[i].advance))
+            panic_ttf("TTF_GlyphMetrics");
+
+        if (pen_x + rendered[i]->w > ATLAS_WIDTH) {
+            pen_x = 0;
+            pen_y += atlas->height + ATLAS_PAD;
+        }
+
+        atlas->glyphs[i].src = (SDL_Rect) { .x = pen_x, .y = pen_y,
+                                            .w = rendered[i]->w, .h = rendered[i]->h };
+        pen_x += rendered[i]->w + ATLAS_PAD;
+    }
+
+    atlas->tex_w = ATLAS_WIDTH;
+    atlas->tex_h = pen_y + atlas->height;
+
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, atlas->tex_w, atlas->tex_h,
+                                                        32, SDL_PIXELFORMAT_RGBA32);
+    if (!sheet)
+        panic_ttf("CreateRGBSurface");
+    SDL_FillRect(sheet, NULL, 0);
+
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        // copy coverage as-is instead of blending onto the empty sheet
+        SDL_SetSurfaceBlendMode(rendered[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(rendered[i], NULL, sheet, &atlas->glyphs[i].src);
+        SDL_FreeSurface(rendered[i]);
+    }
+
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    if (!atlas->texture)
+        panic_ttf("CreateTextureFromSurface");
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+
+    SDL_FreeSurface(sheet);
+}
+
+void text_init(void)
+{
+    atlas_build(&atlases[atlas_count++], font_small);
+    atlas_build(&atlases[atlas_count++], font);
+    atlas_build(&atlases[atlas_count++], font_huge);
+}
+
+static Atlas *atlas_get(TTF_Font *atlas_font)
+{
+    for (int i = 0; i < atlas_count; i++)
+        if (atlases[i].font == atlas_font)
+            return &atlases[i];
+
+    fprintf(stderr, "text: no atlas for font %p\n", (void *)atlas_font);
+    exit(1);
+}
+
+static Glyph *atlas_glyph(Atlas *atlas, unsigned char c)
+{
+    if (c < GLYPH_FIRST || c > GLYPH_LAST)
+        c = '?';
+
+    return &atlas->glyphs[c - GLYPH_FIRST];
+}
+
+static void atlas_reserve(Atlas *atlas, int nquads)
+{
+    if (atlas->nquads + nquads <= atlas->cap)
+        return;
+
+    int cap = atlas->cap ? atlas->cap : 256;
+    while (cap < atlas->nquads + nquads)
+        cap *= 2;
+
+    atlas->verts = realloc(atlas->verts, sizeof(SDL_Vertex) * 4 * cap);
+    atlas->indices = realloc(atlas->indices, sizeof(int) * 6 * cap);
+    if (!atlas->verts || !atlas->indices) {
+        fprintf(stderr, "text: out of memory\n");
+        exit(1);
+    }
+    atlas->cap = cap;
+}
+
+int text_width(const char *text, TTF_Font *text_font)
+{
+    Atlas *atlas = atlas_get(text_font);
+
+    int w = 0;
+    for (const char *c = text; *c; c++)
+        w += atlas_glyph(atlas, *c)->advance;
+
+    return w;
+}
+
+void render_text(const char *text, int x, int y, TTF_Font *text_font)
+{
+    PROF_BEGIN(PROF_RENDER_TEXT);
+
+    Atlas *atlas = atlas_get(text_font);
+    SDL_Color white = {255, 255, 255, 255};
+
+    atlas_reserve(atlas, strlen(text));
+
+    float pen_x = x;
+    for (const char *c = text; *c; c++) {
+        Glyph *g = atlas_glyph(atlas, *c);
+
+        float u1 = (float)g->src.x / atlas->tex_w;
+        float v1 = (float)g->src.y / atlas->tex_h;
+        float u2 = (float)(g->src.x + g->src.w) / atlas->tex_w;
+        float v2 = (float)(g->src.y + g->src.h) / atlas->tex_h;
+
+        float x1 = pen_x, y1 = y;
+        float x2 = pen_x + g->src.w, y2 = y + g->src.h;
+
+        int base = atlas->nquads * 4;
+        SDL_Vertex *v = &atlas->verts[base];
+        v[0] = (SDL_Vertex) { {x1, y1}, white, {u1, v1} };
+        v[1] = (SDL_Vertex) { {x2, y1}, white, {u2, v1} };
+        v[2] = (SDL_Vertex) { {x2, y2}, white, {u2, v2} };
+        v[3] = (SDL_Vertex) { {x1, y2}, white, {u1, v2} };
+
+        int *idx = &atlas->indices[atlas->nquads * 6];
+        idx[0] = base;     idx[1] = base + 1; idx[2] = base + 2;
+        idx[3] = base;     idx[4] = base + 2; idx[5] = base + 3;
+
+        atlas->nquads++;
+        pen_x += g->advance;
+    }
+
+    PROF_END(PROF_RENDER_TEXT);
+}
+
+void text_flush(void)
+{
+    PROF_BEGIN(PROF_TEXT_FLUSH);
+
+    for (int i = 0; i < atlas_count; i++) {
+        Atlas *atlas = &atlases[i];
+        if (!atlas->nquads)
+            continue;
+
+        SDL_RenderGeometry(renderer, atlas->texture,
+                           atlas->verts, atlas->nquads * 4,
+                           atlas->indices, atlas->nquads * 6);
+        atlas->nquads = 0;
+    }
+
+    PROF_END(PROF_TEXT_FLUSH);
+}
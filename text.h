@@ -0,0 +1,12 @@
+#ifndef _TEXT_H
+#define _TEXT_H
+
+#include <SDL2/SDL_ttf.h>
+
+void text_init(void);
+
+void render_text(const char *text, int x, int y, TTF_Font *font);
+int text_width(const char *text, TTF_Font *font);
+void text_flush(void);
+
+#endif /* _TEXT_H */
@@ -0,0 +1,163 @@
+#!/usr/bin/env node
+/*
+ * Headless runner for the benchmark of a wasm build: runs the module under
+ * node with --bench, parses the per-scene table and prints a summary.
+ *
+ *   node wasm_bench.js [build.js] [frames] [--json out.json]
+ *                      [--baseline base.json] [--tolerance 0.15]
+ *
+ * With --baseline, exits with status 1 when the mean frame time of any
+ * scene got slower than the baseline by more than the tolerance. A native
+ * binary can be given instead of a .js file to compare against it.
+ */
+
+'use strict';
+
+const { spawnSync } = require('child_process');
+const fs = require('fs');
+const path = require('path');
+
+function usage() {
+    console.error('usage: node wasm_bench.js [build.js] [frames] [--json out.json] ' +
+                  '[--baseline base.json] [--tolerance fraction]');
+    process.exit(2);
+}
+
+function parseArgs(argv) {
+    const opts = { build: './waves-bench.js', frames: 500, json: null, baseline: null, tolerance: 0.15 };
+    const positional = [];
+
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        if (arg === '--json' && i + 1 < argv.length)
+            opts.json = argv[++i];
+        else if (arg === '--baseline' && i + 1 < argv.length)
+            opts.baseline = argv[++i];
+        else if (arg === '--tolerance' && i + 1 < argv.length)
+            opts.tolerance = parseFloat(argv[++i]);
+        else if (arg.startsWith('-'))
+            usage();
+        else
+            positional.push(arg);
+    }
+
+    if (positional.length > 2)
+        usage();
+    if (positional.length > 0)
+        opts.build = positional[0];
+    if (positional.length > 1)
+        opts.frames = parseInt(positional[1], 10);
+    if (!(opts.frames > 0) || !(opts.tolerance >= 0))
+        usage();
+
+    return opts;
+}
+
+function run(opts) {
+    const build = path.resolve(opts.build);
+    const args = ['--bench', String(opts.frames)];
+
+    // the wasm build reads res/ from its embedded file system, a native one from its cwd
+    const cmd = build.endsWith('.js') ? process.execPath : build;
+    const cmdArgs = build.endsWith('.js') ? [build, ...args] : args;
+
+    const start = process.hrtime.bigint();
+    const res = spawnSync(cmd, cmdArgs, { cwd: path.dirname(build), encoding: 'utf8',
+                                          maxBuffer: 64 << 20 });
+    const wall = Number(process.hrtime.bigint() - start) / 1e9;
+
+    if (res.error) {
+        console.error(`wasm_bench: ${res.error.message}`);
+        process.exit(1);
+    }
+    if (res.status !== 0) {
+        process.stderr.write(res.stderr);
+        console.error(`wasm_bench: ${opts.build} exited with status ${res.status}`);
+        process.exit(1);
+    }
+
+    return { output: res.stdout, wall };
+}
+
+/*
+ * The first table of the bench output has one line per scene and stage:
+ *   scene stage mean p50 p90 p99 max
+ * it ends at the first empty line.
+ */
+function parseScenes(output) {
+    const scenes = {};
+    const lines = output.split('\n');
+
+    let i = lines.findIndex(l => /^scene\s+stage\s+mean/.test(l));
+    if (i < 0)
+        return scenes;
+
+    for (i++; i < lines.length && lines[i].trim() !== ''; i++) {
+        const f = lines[i].trim().split(/\s+/);
+        if (f.length !== 7)
+            continue;
+
+        const [scene, stage, mean, p50, p90, p99, max] = f;
+        scenes[scene] = scenes[scene] || {};
+        scenes[scene][stage] = { mean: +mean, p50: +p50, p90: +p90, p99: +p99, max: +max };
+    }
+
+    return scenes;
+}
+
+function report(scenes, baseline, tolerance) {
+    const ms = ns => (ns / 1e6).toFixed(3);
+    let regressed = false;
+
+    console.log(`${'scene'.padEnd(14)} ${'mean'.padStart(10)} ${'p99'.padStart(10)}` +
+                `${baseline ? ' ' + 'base'.padStart(10) + ' ' + 'change'.padStart(8) : ''}   [ms/frame]`);
+
+    for (const [name, stages] of Object.entries(scenes)) {
+        const frame = stages.frame;
+        if (!frame)
+            continue;
+
+        let line = `${name.padEnd(14)} ${ms(frame.mean).padStart(10)} ${ms(frame.p99).padStart(10)}`;
+
+        const base = baseline && baseline[name] && baseline[name].frame;
+        if (base) {
+            const change = frame.mean / base.mean - 1;
+            const slower = change > tolerance;
+            regressed = regressed || slower;
+            line += ` ${ms(base.mean).padStart(10)} ${((change * 100).toFixed(1) + '%').padStart(8)}` +
+                    (slower ? '  REGRESSION' : '');
+        }
+
+        console.log(line);
+    }
+
+    return regressed;
+}
+
+function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    const { output, wall } = run(opts);
+
+    const scenes = parseScenes(output);
+    if (Object.keys(scenes).length === 0) {
+        process.stdout.write(output);
+        console.error('wasm_bench: no scene table in the output');
+        process.exit(1);
+    }
+
+    const baseline = opts.baseline ? JSON.parse(fs.readFileSync(opts.baseline, 'utf8')).scenes : null;
+    const regressed = report(scenes, baseline, opts.tolerance);
+    console.log(`\n${opts.build}: ${opts.frames} frames per scene, ${wall.toFixed(1)} s wall`);
+
+    if (opts.json) {
+        const result = { build: opts.build, frames: opts.frames, node: process.version, scenes };
+        fs.writeFileSync(opts.json, JSON.stringify(result, null, 2) + '\n');
+    }
+
+    if (regressed) {
+        console.error(`wasm_bench: mean frame time regressed by more than ${opts.tolerance * 100}%`);
+        process.exit(1);
+    }
+}
+
+main();
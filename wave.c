@@ -0,0 +1,498 @@
+#include <stddef.h>
+#include <math.h>
+
+#if defined(__x86_64__)
+#define WAVE_X86
+#include <immintrin.h>
+#elif defined(__wasm_simd128__)
+#define WAVE_WASM
+#include <wasm_simd128.h>
+#endif
+
+#include "wave.h"
+
+#define TWO_PI 6.283185307179586
+
+/*
+ * sin(y) on [-pi/2, pi/2] as an odd degree 9 polynomial, |err| < 4e-6.
+ * Callers fold x from [-pi, pi] into that range with
+ * y = max(min(x, pi - x), -pi - x).
+ */
+#define SIN_C1 1.0f
+#define SIN_C3 -0.16666666666f
+#define SIN_C5 0.0083333315f
+#define SIN_C7 -0.0001984090f
+#define SIN_C9 0.0000027526f
+
+// 2pi split in two parts for the range reduction
+#define TWO_PI_HI 6.28125f
+#define TWO_PI_LO 1.9353071795864769e-3f
+#define INV_TWO_PI 0.15915494309189535f
+
+#define BLOCK 8
+
+typedef void (*WaveKernel)(float *out, int n, double phase, double step, float amplitude);
+typedef void (*RadialKernel)(float *acc, int n, float dx, float dy, float k, float phase);
+typedef void (*PointsKernel)(float *out, const float *x, int n, float k, float phase, float amplitude);
+
+double wave_func(double t, double x,
+                 double period, double lambda,
+                 double amplitude, double phi)
+{
+    return amplitude * sin(2*PI*(t/period - x/lambda) + phi);
+}
+
+static double reduce_phase(double phase)
+{
+    return phase - TWO_PI * nearbyint(phase / TWO_PI);
+}
+
+static float sin_poly(float x)
+{
+    // one quotient for both parts, the second must not be rounded again
+    float q = nearbyintf(x * INV_TWO_PI);
+    x -= TWO_PI_HI * q;
+    x -= TWO_PI_LO * q;
+
+    float y = fmaxf(fminf(x, PI - x), -PI - x);
+    float y2 = y*y;
+
+    return y * (SIN_C1 + y2*(SIN_C3 + y2*(SIN_C5 + y2*(SIN_C7 + y2*SIN_C9))));
+}
+
+/*
+ * All kernels compute out[i] = amplitude * sin(phase - i*step). The phase of
+ * the first lane of every block is reduced in double precision so that the
+ * float lanes never see large arguments, no matter how long t has been running.
+ */
+static void kernel_scalar(float *out, int n, double phase, double step, float amplitude)
+{
+    for (int i = 0; i < n; i++)
+        out[i] = amplitude * sin_poly((float)reduce_phase(phase - i*step));
+}
+
+/*
+ * Radial kernels accumulate acc[i] += sin(phase - k*r) with r the distance of
+ * (dx + i, dy) from the source. phase is expected to be reduced already.
+ */
+static void radial_scalar(float *acc, int n, float dx, float dy, float k, float phase)
+{
+    for (int i = 0; i < n; i++) {
+        float x = dx + i;
+        acc[i] += sin_poly(phase - k*sqrtf(x*x + dy*dy));
+    }
+}
+
+/*
+ * Point kernels compute out[i] = amplitude * sin(phase - k*x[i]) for
+ * arbitrary x, phase is expected to be reduced already.
+ */
+static void points_scalar(float *out, const float *x, int n, float k, float phase, float amplitude)
+{
+    for (int i = 0; i < n; i++)
+        out[i] = amplitude * sin_poly(phase - k*x[i]);
+}
+
+#ifdef WAVE_X86
+static inline __m128 sin_sse2(__m128 x)
+{
+    const __m128 pi = _mm_set1_ps(PI), neg_pi = _mm_set1_ps(-PI);
+
+    __m128 q = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(INV_TWO_PI))));
+    x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(TWO_PI_HI)));
+    x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(TWO_PI_LO)));
+
+    __m128 y = _mm_max_ps(_mm_min_ps(x, _mm_sub_ps(pi, x)), _mm_sub_ps(neg_pi, x));
+    __m128 y2 = _mm_mul_ps(y, y);
+
+    __m128 p = _mm_set1_ps(SIN_C9);
+    p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps(SIN_C7));
+    p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps(SIN_C5));
+    p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps(SIN_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps(SIN_C1));
+
+    return _mm_mul_ps(p, y);
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 sin_avx2(__m256 x)
+{
+    const __m256 pi = _mm256_set1_ps(PI), neg_pi = _mm256_set1_ps(-PI);
+
+    __m256 q = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(INV_TWO_PI)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_fnmadd_ps(q, _mm256_set1_ps(TWO_PI_HI), x);
+    x = _mm256_fnmadd_ps(q, _mm256_set1_ps(TWO_PI_LO), x);
+
+    __m256 y = _mm256_max_ps(_mm256_min_ps(x, _mm256_sub_ps(pi, x)), _mm256_sub_ps(neg_pi, x));
+    __m256 y2 = _mm256_mul_ps(y, y);
+
+    __m256 p = _mm256_set1_ps(SIN_C9);
+    p = _mm256_fmadd_ps(p, y2, _mm256_set1_ps(SIN_C7));
+    p = _mm256_fmadd_ps(p, y2, _mm256_set1_ps(SIN_C5));
+    p = _mm256_fmadd_ps(p, y2, _mm256_set1_ps(SIN_C3));
+    p = _mm256_fmadd_ps(p, y2, _mm256_set1_ps(SIN_C1));
+
+    return _mm256_mul_ps(p, y);
+}
+
+static void kernel_sse2(float *out, int n, double phase, double step, float amplitude)
+{
+    const __m128 lanes = _mm_setr_ps(0, 1, 2, 3);
+    const __m128 vstep = _mm_set1_ps((float)reduce_phase(step));
+    const __m128 vamp = _mm_set1_ps(amplitude);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 base = _mm_set1_ps((float)reduce_phase(phase - i*step));
+        __m128 x = _mm_sub_ps(base, _mm_mul_ps(lanes, vstep));
+
+        _mm_storeu_ps(&out[i], _mm_mul_ps(vamp, sin_sse2(x)));
+    }
+
+    kernel_scalar(&out[i], n - i, phase - i*step, step, amplitude);
+}
+
+__attribute__((target("avx2,fma")))
+static void kernel_avx2(float *out, int n, double phase, double step, float amplitude)
+{
+    const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 vstep = _mm256_set1_ps((float)reduce_phase(step));
+    const __m256 vamp = _mm256_set1_ps(amplitude);
+
+    int i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        __m256 base = _mm256_set1_ps((float)reduce_phase(phase - i*step));
+        __m256 x = _mm256_fnmadd_ps(lanes, vstep, base);
+
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(vamp, sin_avx2(x)));
+    }
+
+    kernel_sse2(&out[i], n - i, phase - i*step, step, amplitude);
+}
+
+static void radial_sse2(float *acc, int n, float dx, float dy, float k, float phase)
+{
+    const __m128 lanes = _mm_setr_ps(0, 1, 2, 3);
+    const __m128 vdy2 = _mm_set1_ps(dy*dy);
+    const __m128 vk = _mm_set1_ps(k);
+    const __m128 vphase = _mm_set1_ps(phase);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_add_ps(_mm_set1_ps(dx + i), lanes);
+        __m128 r = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), vdy2));
+        __m128 s = sin_sse2(_mm_sub_ps(vphase, _mm_mul_ps(vk, r)));
+
+        _mm_storeu_ps(&acc[i], _mm_add_ps(_mm_loadu_ps(&acc[i]), s));
+    }
+
+    radial_scalar(&acc[i], n - i, dx + i, dy, k, phase);
+}
+
+__attribute__((target("avx2,fma")))
+static void radial_avx2(float *acc, int n, float dx, float dy, float k, float phase)
+{
+    const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 vdy2 = _mm256_set1_ps(dy*dy);
+    const __m256 vk = _mm256_set1_ps(k);
+    const __m256 vphase = _mm256_set1_ps(phase);
+
+    int i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        __m256 x = _mm256_add_ps(_mm256_set1_ps(dx + i), lanes);
+        __m256 r = _mm256_sqrt_ps(_mm256_fmadd_ps(x, x, vdy2));
+        __m256 s = sin_avx2(_mm256_fnmadd_ps(vk, r, vphase));
+
+        _mm256_storeu_ps(&acc[i], _mm256_add_ps(_mm256_loadu_ps(&acc[i]), s));
+    }
+
+    radial_sse2(&acc[i], n - i, dx + i, dy, k, phase);
+}
+
+static void points_sse2(float *out, const float *x, int n, float k, float phase, float amplitude)
+{
+    const __m128 vk = _mm_set1_ps(k);
+    const __m128 vphase = _mm_set1_ps(phase);
+    const __m128 vamp = _mm_set1_ps(amplitude);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 s = sin_sse2(_mm_sub_ps(vphase, _mm_mul_ps(vk, _mm_loadu_ps(&x[i]))));
+        _mm_storeu_ps(&out[i], _mm_mul_ps(vamp, s));
+    }
+
+    points_scalar(&out[i], &x[i], n - i, k, phase, amplitude);
+}
+
+__attribute__((target("avx2,fma")))
+static void points_avx2(float *out, const float *x, int n, float k, float phase, float amplitude)
+{
+    const __m256 vk = _mm256_set1_ps(k);
+    const __m256 vphase = _mm256_set1_ps(phase);
+    const __m256 vamp = _mm256_set1_ps(amplitude);
+
+    int i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        __m256 s = sin_avx2(_mm256_fnmadd_ps(vk, _mm256_loadu_ps(&x[i]), vphase));
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(vamp, s));
+    }
+
+    points_sse2(&out[i], &x[i], n - i, k, phase, amplitude);
+}
+#endif /* WAVE_X86 */
+
+#ifdef WAVE_WASM
+static inline v128_t sin_simd128(v128_t x)
+{
+    const v128_t pi = wasm_f32x4_splat(PI), neg_pi = wasm_f32x4_splat(-PI);
+
+    v128_t q = wasm_f32x4_nearest(wasm_f32x4_mul(x, wasm_f32x4_splat(INV_TWO_PI)));
+    x = wasm_f32x4_sub(x, wasm_f32x4_mul(q, wasm_f32x4_splat(TWO_PI_HI)));
+    x = wasm_f32x4_sub(x, wasm_f32x4_mul(q, wasm_f32x4_splat(TWO_PI_LO)));
+
+    v128_t y = wasm_f32x4_max(wasm_f32x4_min(x, wasm_f32x4_sub(pi, x)), wasm_f32x4_sub(neg_pi, x));
+    v128_t y2 = wasm_f32x4_mul(y, y);
+
+    v128_t p = wasm_f32x4_splat(SIN_C9);
+    p = wasm_f32x4_add(wasm_f32x4_mul(p, y2), wasm_f32x4_splat(SIN_C7));
+    p = wasm_f32x4_add(wasm_f32x4_mul(p, y2), wasm_f32x4_splat(SIN_C5));
+    p = wasm_f32x4_add(wasm_f32x4_mul(p, y2), wasm_f32x4_splat(SIN_C3));
+    p = wasm_f32x4_add(wasm_f32x4_mul(p, y2), wasm_f32x4_splat(SIN_C1));
+
+    return wasm_f32x4_mul(p, y);
+}
+
+static void kernel_simd128(float *out, int n, double phase, double step, float amplitude)
+{
+    const v128_t lanes = wasm_f32x4_make(0, 1, 2, 3);
+    const v128_t vstep = wasm_f32x4_splat((float)reduce_phase(step));
+    const v128_t vamp = wasm_f32x4_splat(amplitude);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        v128_t base = wasm_f32x4_splat((float)reduce_phase(phase - i*step));
+        v128_t x = wasm_f32x4_sub(base, wasm_f32x4_mul(lanes, vstep));
+
+        wasm_v128_store(&out[i], wasm_f32x4_mul(vamp, sin_simd128(x)));
+    }
+
+    kernel_scalar(&out[i], n - i, phase - i*step, step, amplitude);
+}
+
+static void radial_simd128(float *acc, int n, float dx, float dy, float k, float phase)
+{
+    const v128_t lanes = wasm_f32x4_make(0, 1, 2, 3);
+    const v128_t vdy2 = wasm_f32x4_splat(dy*dy);
+    const v128_t vk = wasm_f32x4_splat(k);
+    const v128_t vphase = wasm_f32x4_splat(phase);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        v128_t x = wasm_f32x4_add(wasm_f32x4_splat(dx + i), lanes);
+        v128_t r = wasm_f32x4_sqrt(wasm_f32x4_add(wasm_f32x4_mul(x, x), vdy2));
+        v128_t s = sin_simd128(wasm_f32x4_sub(vphase, wasm_f32x4_mul(vk, r)));
+
+        wasm_v128_store(&acc[i], wasm_f32x4_add(wasm_v128_load(&acc[i]), s));
+    }
+
+    radial_scalar(&acc[i], n - i, dx + i, dy, k, phase);
+}
+
+static void points_simd128(float *out, const float *x, int n, float k, float phase, float amplitude)
+{
+    const v128_t vk = wasm_f32x4_splat(k);
+    const v128_t vphase = wasm_f32x4_splat(phase);
+    const v128_t vamp = wasm_f32x4_splat(amplitude);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        v128_t s = sin_simd128(wasm_f32x4_sub(vphase, wasm_f32x4_mul(vk, wasm_v128_load(&x[i]))));
+        wasm_v128_store(&out[i], wasm_f32x4_mul(vamp, s));
+    }
+
+    points_scalar(&out[i], &x[i], n - i, k, phase, amplitude);
+}
+#endif /* WAVE_WASM */
+
+// scalar until wave_init() picks the best the CPU supports
+static WaveKernel kernel = kernel_scalar;
+static RadialKernel radial = radial_scalar;
+static PointsKernel points = points_scalar;
+static const char *kernel_name = "scalar";
+
+void wave_init(void)
+{
+#if defined(WAVE_X86)
+    kernel = kernel_sse2;
+    radial = radial_sse2;
+    points = points_sse2;
+    kernel_name = "sse2";
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        kernel = kernel_avx2;
+        radial = radial_avx2;
+        points = points_avx2;
+        kernel_name = "avx2";
+    }
+#elif defined(WAVE_WASM)
+    kernel = kernel_simd128;
+    radial = radial_simd128;
+    points = points_simd128;
+    kernel_name = "simd128";
+#endif
+}
+
+const char *wave_kernel_name(void)
+{
+    return kernel_name;
+}
+
+void wave_func_batch(float *out, int n,
+                     double t, double x0, double dx,
+                     double period, double lambda,
+                     double amplitude, double phi)
+{
+    double phase = 2*PI*(t/period - x0/lambda) + phi;
+    double step = 2*PI*dx/lambda;
+
+    kernel(out, n, phase, step, (float)amplitude);
+}
+
+void wave_radial_accum(float *acc, int n,
+                       double x0, double y, double src_x, double src_y,
+                       double t, double period, double lambda, double phi)
+{
+    float phase = (float)reduce_phase(2*PI*(t/period) + phi);
+    float k = (float)(2*PI/lambda);
+
+    radial(acc, n, (float)(x0 - src_x), (float)(y - src_y), k, phase);
+}
+
+void wave_func_points(float *out, const float *x, int n,
+                      double t, double period, double lambda,
+                      double amplitude, double phi)
+{
+    float phase = (float)reduce_phase(2*PI*(t/period) + phi);
+    float k = (float)(2*PI/lambda);
+
+    points(out, x, n, k, phase, (float)amplitude);
+}
+
+// longest run simplified as one segment, bounds the unbalanced splits of ringing curves
+#define WAVE_SIMPLIFY_CHUNK 128
+
+static int simplify_segment(const float *y, int a, int b, float scale, float tol, int *keep, int count)
+{
+    float slope = (y[b] - y[a]) / (b - a);
+    float worst = tol;
+    int split = -1;
+
+    for (int i = a + 1; i < b; i++) {
+        float d = fabsf(y[i] - (y[a] + slope * (i - a))) * scale;
+        if (d > worst) {
+            worst = d;
+            split = i;
+        }
+    }
+
+    if (split < 0)
+        return count;
+
+    count = simplify_segment(y, a, split, scale, tol, keep, count);
+    keep[count++] = split;
+    return simplify_segment(y, split, b, scale, tol, keep, count);
+}
+
+int wave_simplify(const float *y, int n, float scale, float tol, int *keep)
+{
+    if (n < 3) {
+        for (int i = 0; i < n; i++)
+            keep[i] = i;
+        return n;
+    }
+
+    int count = 0;
+    keep[count++] = 0;
+
+    for (int a = 0; a < n - 1; a += WAVE_SIMPLIFY_CHUNK) {
+        int b = a + WAVE_SIMPLIFY_CHUNK < n - 1 ? a + WAVE_SIMPLIFY_CHUNK : n - 1;
+        count = simplify_segment(y, a, b, scale, tol, keep, count);
+        keep[count++] = b;
+    }
+
+    return count;
+}
+
+static void wave_phasor_resync(WavePhasor *w)
+{
+    double phase = reduce_phase(2*PI*(w->t/w->period) + w->phi);
+
+    w->re = cos(phase);
+    w->im = sin(phase);
+    w->steps = 0;
+}
+
+/* (Re)builds the rotations if any parameter changed, keeping the current t. */
+void wave_phasor_set(WavePhasor *w, double dt, double dx,
+                     double period, double lambda,
+                     double amplitude, double phi)
+{
+    if (w->dt == dt && w->dx == dx &&
+        w->period == period && w->lambda == lambda &&
+        w->amplitude == amplitude && w->phi == phi)
+        return;
+
+    w->dt = dt;
+    w->dx = dx;
+    w->period = period;
+    w->lambda = lambda;
+    w->amplitude = amplitude;
+    w->phi = phi;
+
+    double step_t = reduce_phase(2*PI*dt/period);
+    w->rot_t_re = cos(step_t);
+    w->rot_t_im = sin(step_t);
+
+    double step_x = reduce_phase(2*PI*dx/lambda);
+    w->rot_x_re = cos(step_x);
+    w->rot_x_im = -sin(step_x);
+
+    wave_phasor_resync(w);
+}
+
+void wave_phasor_step(WavePhasor *w)
+{
+    w->t += w->dt;
+
+    if (++w->steps >= WAVE_PHASOR_RESYNC) {
+        wave_phasor_resync(w);
+        return;
+    }
+
+    double re = w->re*w->rot_t_re - w->im*w->rot_t_im;
+    double im = w->re*w->rot_t_im + w->im*w->rot_t_re;
+
+    // first order renormalization, keeps |z| at 1 without a sqrt
+    double k = (3 - (re*re + im*im)) / 2;
+    w->re = re * k;
+    w->im = im * k;
+}
+
+void wave_phasor_sample(const WavePhasor *w, float *out, int n, double x0)
+{
+    double offset = reduce_phase(-2*PI*x0/w->lambda);
+    double c = cos(offset), s = sin(offset);
+
+    double re = w->re*c - w->im*s;
+    double im = w->re*s + w->im*c;
+
+    for (int i = 0; i < n; i++) {
+        out[i] = w->amplitude * im;
+
+        double nre = re*w->rot_x_re - im*w->rot_x_im;
+        im = re*w->rot_x_im + im*w->rot_x_re;
+        re = nre;
+    }
+}
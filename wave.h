@@ -0,0 +1,94 @@
+#ifndef _WAVE_H
+#define _WAVE_H
+
+#include <math.h>
+#include <float.h>
+
+#define PI 3.14159265358f
+
+double wave_func(double t, double x,
+                 double period, double lambda,
+                 double amplitude, double phi);
+
+/*
+ * Fills out[i] = wave_func(t, x0 + i*dx, ...) for i in [0, n), using a
+ * vectorized sine approximation (absolute error below
+ * WAVE_BATCH_MAX_ERR * amplitude).
+ */
+#define WAVE_BATCH_MAX_ERR 1e-5
+
+/*
+ * The radial and point kernels form the spatial phase (k*r, k*x) in float,
+ * their error also grows with that phase, in radians.
+ */
+#define WAVE_PHASE_MAX_ERR(phase) (WAVE_BATCH_MAX_ERR + 2 * FLT_EPSILON * fabs(phase))
+
+void wave_func_batch(float *out, int n,
+                     double t, double x0, double dx,
+                     double period, double lambda,
+                     double amplitude, double phi);
+
+/*
+ * Adds the unit amplitude circular wave of a point source at (src_x, src_y)
+ * to acc[i] for the points (x0 + i, y), i in [0, n). Uses the same kernel
+ * family as wave_func_batch().
+ */
+void wave_radial_accum(float *acc, int n,
+                       double x0, double y, double src_x, double src_y,
+                       double t, double period, double lambda, double phi);
+
+/*
+ * Fills out[i] = wave_func(t, x[i], ...) for i in [0, n) at arbitrary
+ * points, with the same kernels. Only the time phase is reduced in double
+ * precision, k*x[i] is taken in float, so x should stay within a few
+ * thousand wavelengths of 0.
+ */
+void wave_func_points(float *out, const float *x, int n,
+                      double t, double period, double lambda,
+                      double amplitude, double phi);
+
+/*
+ * Picks the kernels for this CPU. Call it once on the main thread before
+ * any other thread samples a wave, the selection is not synchronized.
+ */
+void wave_init(void);
+const char *wave_kernel_name(void);
+
+/*
+ * Incremental sampler for a wave on a uniform x grid that advances by a
+ * constant time step. The phase at x = 0 is kept as a unit phasor that is
+ * rotated once per step and resynced from t every WAVE_PHASOR_RESYNC steps,
+ * samples along x are produced by repeated rotation as well.
+ */
+#define WAVE_PHASOR_RESYNC 256
+
+typedef struct WavePhasor {
+    double dt, dx;
+    double period, lambda, amplitude, phi;
+
+    double t;
+    int steps;
+
+    double re, im;          // e^(i*phase) at x = 0
+    double rot_t_re, rot_t_im;
+    double rot_x_re, rot_x_im;
+} WavePhasor;
+
+void wave_phasor_set(WavePhasor *w, double dt, double dx,
+                     double period, double lambda,
+                     double amplitude, double phi);
+void wave_phasor_step(WavePhasor *w);
+void wave_phasor_sample(const WavePhasor *w, float *out, int n, double x0);
+
+/*
+ * Adaptive vertex selection for a curve sampled at unit spacing: keeps the
+ * fewest samples of y[0, n) such that the polyline through them stays within
+ * tol of every sample, with y scaled by scale first. Segments are split at
+ * their worst sample until they fit. The curve is cut into fixed chunks
+ * first, whose ends are kept, so a curve that only ever splits off one
+ * sample at a time costs O(n * chunk) rather than O(n^2). Writes the kept
+ * indices in order to keep (room for n) and returns their count.
+ */
+int wave_simplify(const float *y, int n, float scale, float tol, int *keep);
+
+#endif /* _WAVE_H */
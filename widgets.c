@@ -2,7 +2,12 @@
 #include "simstate.h"
 #include "config.h"
 #include "draw.h"
+#include "text.h"
+#include "drawlist.h"
 #include "utils.h"
+#include "sim.h"
+#include "prof.h"
+#include "comp.h"
 
 #include <assert.h>
 
@@ -13,6 +18,7 @@ extern TTF_Font *font;
 void callback_switch_scene(void *data)
 {
     SIM_STATE.sel_scene = data;
+    sim_select_scene(data);
 }
 
 void callback_slider_setvar_double(void *data)
@@ -20,7 +26,7 @@ void callback_slider_setvar_double(void *data)
     Widget *slider = (Widget *)data;
     assert(slider && slider->widget_type == WIDGET_SLIDER);
 
-    *(double *)slider->slider_var = slider->slider_value;
+    sim_param_set_double(slider->slider_var, slider->slider_value);
 }
 
 void callback_slider_setvar_int(void *data)
@@ -28,20 +34,20 @@ void callback_slider_setvar_int(void *data)
     Widget *slider = (Widget *)data;
     assert(slider && slider->widget_type == WIDGET_SLIDER);
 
-    *(int *)slider->slider_var = (int)slider->slider_value;
+    sim_param_set_int(slider->slider_var, (int)slider->slider_value);
 }
 
 void widget_draw_button(const char *label,
                    int x1, int y1, int x2, int y2)
 {
-    rectangleColor(renderer, x1, y1, x2, y2, 0xFFFFFFFF);
+    dl_rect(x1, y1, x2, y2, 255, 255, 255, 255);
 
     int button_width = x2-x1;
     int button_height = y2-y1;
 
-    int text_width = strlen(label)*22;
+    int label_width = text_width(label, font);
 
-    render_text(label, x1 + button_width/2 - text_width/2, y1 + button_height/2 - button_height/3, font);
+    render_text(label, x1 + button_width/2 - label_width/2, y1 + button_height/2 - button_height/3, font);
 }
 
 void widget_draw_slider(const char *label,
@@ -55,16 +61,14 @@ void widget_draw_slider(const char *label,
     int progress = slider_width * fabs((slider_value-slider_min)/(slider_max-slider_min));
 
     // draw bar
-    boxColor(renderer,
-             x1, y1+slider_height/2-thickness,
-             x2, y1+slider_height/2+thickness,
-             0xFFFFFFFF);
+    dl_box(x1, y1+slider_height/2-thickness,
+           x2, y1+slider_height/2+thickness,
+           255, 255, 255, 255);
 
     // draw slider 'caret' (?)
-    boxRGBA(renderer,
-            x1+progress,             y1+slider_height/2-thickness*5,
-            x1+progress+thickness*2, y1+slider_height/2+thickness*5,
-            100, 100, 100, 255);
+    dl_box(x1+progress,             y1+slider_height/2-thickness*5,
+           x1+progress+thickness*2, y1+slider_height/2+thickness*5,
+           100, 100, 100, 255);
 
     render_text(label, x1, y1-10, font);
 
@@ -75,6 +79,8 @@ void widget_draw_slider(const char *label,
 
 void draw_widget(Widget *widget)
 {
+    PROF_BEGIN(PROF_DRAW_WIDGET);
+
     switch (widget->widget_type) {
     case WIDGET_BUTTON:
         widget_draw_button(widget->label,
@@ -86,55 +92,67 @@ void draw_widget(Widget *widget)
                            widget->x1, widget->y1,
                            widget->x2, widget->y2,
                            widget->slider_min, widget->slider_max, widget->slider_value);
+        break;
+    case WIDGET_PLOT:
+        plot_draw_frame(widget->plot, widget->label,
+                        widget->x1, widget->y1,
+                        widget->x2, widget->y2);
+        break;
     default:
         break;
     }
+
+    PROF_END(PROF_DRAW_WIDGET);
 }
 
-void widget_update_sliders(int x, int y)
-{
-    Scene *scene = SIM_STATE.sel_scene;
+#define SLIDER_PAD 10
 
-    for (int i = 0; i < CONFIG_MAX_WIDGETS; i++) {
-        if (scene->widgets[i].widget_type != WIDGET_SLIDER)
-            break;
+/* Area that reacts to the mouse, sliders are a bit wider than drawn. */
+void widget_hit_rect(const Widget *widget, int *x1, int *y1, int *x2, int *y2)
+{
+    int pad = widget->widget_type == WIDGET_SLIDER ? SLIDER_PAD : 0;
 
-#define PAD 10
-        if (x > scene->widgets[i].x1 - PAD && y > scene->widgets[i].y1 &&
-            x < scene->widgets[i].x2 + PAD && y < scene->widgets[i].y2) {
+    *x1 = widget->x1 - pad;
+    *y1 = widget->y1;
+    *x2 = widget->x2 + pad;
+    *y2 = widget->y2;
+}
 
-            double value_range = scene->widgets[i].slider_max - scene->widgets[i].slider_min;
-            double slider_width = scene->widgets[i].x2 - scene->widgets[i].x1;
+bool widget_contains(const Widget *widget, int x, int y)
+{
+    int x1, y1, x2, y2;
+    widget_hit_rect(widget, &x1, &y1, &x2, &y2);
 
-            int cursor_offset = clamp_int(x - scene->widgets[i].x1,
-                                          0, slider_width);
+    return x > x1 && y > y1 && x < x2 && y < y2;
+}
 
-            scene->widgets[i].slider_value = scene->widgets[i].slider_min +
-                value_range * ((double)cursor_offset/slider_width);
+void widget_slider_drag(Widget *slider, int x)
+{
+    assert(slider->widget_type == WIDGET_SLIDER);
 
-            if (!scene->widgets[i].callback)
-                continue;
-            
-            scene->widgets[i].callback(scene->widgets[i].callback_data);
-        }
-    }
-}
+    double value_range = slider->slider_max - slider->slider_min;
+    double slider_width = slider->x2 - slider->x1;
 
+    int cursor_offset = clamp_int(x - slider->x1, 0, slider_width);
+    double value = slider->slider_min + value_range * ((double)cursor_offset/slider_width);
 
-void widget_trigger(int x, int y)
-{
-    Scene *scene = SIM_STATE.sel_scene;
+    if (value == slider->slider_value)
+        return;
 
-    for (int i = 0; i < CONFIG_MAX_WIDGETS; i++) {
-        if (scene->widgets[i].widget_type == WIDGET_END)
-            break;
+    slider->slider_value = value;
+    comp_invalidate_widgets();
 
-        if (x > scene->widgets[i].x1 && y > scene->widgets[i].y1 &&
-            x < scene->widgets[i].x2 && y < scene->widgets[i].y2) {
-            if (!scene->widgets[i].callback)
-                return;
+    if (slider->callback)
+        slider->callback(slider->callback_data);
+}
 
-            scene->widgets[i].callback(scene->widgets[i].callback_data);
-        }
+void widget_press(Widget *widget, int x, int y)
+{
+    if (widget->widget_type == WIDGET_SLIDER) {
+        widget_slider_drag(widget, x);
+        return;
     }
+
+    if (widget->callback)
+        widget->callback(widget->callback_data);
 }
@@ -1,10 +1,13 @@
 #ifndef _WIDGETS_H
 #define _WIDGETS_H
 
+#include <stdbool.h>
+
 #include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "plot.h"
+
 typedef struct SliderSetVar {
     void *var;
     void *value;
@@ -13,6 +16,7 @@ typedef struct SliderSetVar {
 typedef enum WidgetEnum {
     WIDGET_BUTTON,
     WIDGET_SLIDER,
+    WIDGET_PLOT,
     WIDGET_END,
 } WidgetEnum;
 
@@ -30,6 +34,10 @@ typedef struct Widget {
             double slider_min, slider_max, slider_step, slider_value;
             void *slider_var;
         };
+        // plot widget, the frame is drawn with the widgets, the curve every frame
+        struct {
+            Plot *plot;
+        };
     };
 } Widget;
 
@@ -39,7 +47,9 @@ void callback_slider_setvar_int(void *data);
 
 void draw_widget(Widget *widget);
 
-void widget_trigger(int x, int y);
-void widget_update_sliders(int x, int y);
+void widget_hit_rect(const Widget *widget, int *x1, int *y1, int *x2, int *y2);
+bool widget_contains(const Widget *widget, int x, int y);
+void widget_press(Widget *widget, int x, int y);
+void widget_slider_drag(Widget *slider, int x);
 
 #endif /* _WIDGETS_H */